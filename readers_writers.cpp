@@ -6,17 +6,31 @@
 #include <vector>
 #include <random>
 #include <atomic>
+#include "readers_writers_async.h"
+#include "readers_writers_bench.h"
+#include "readers_writers_combining.h"
+#include "readers_writers_handoff.h"
+#include "readers_writers_map.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
 
 class ReadersWriterLock {
 private:
-    std::mutex mtx;                // Protects access to reader_count
-    std::mutex resource_mutex;     // Provides exclusive access to the resource
-    std::condition_variable write_cv; // Condition variable for writers
+    // Exclusion follows from the state below alone: a writer only becomes active when
+    // reader_count is 0, and readers only enter while no writer is active
+    std::mutex mtx;                // Protects the lock state
+    std::condition_variable read_cv;  // Readers wait here
+    std::condition_variable write_cv; // Writers wait here, so a release wakes only who can proceed
     
     int reader_count = 0;          // Number of active readers
     bool writer_active = false;    // Flag to check if writer is active
+    int waiting_readers = 0;       // Number of waiting readers
     int waiting_writers = 0;       // Number of waiting writers
     
+    WaitStrategy wait;             // Spin-then-park policy for blocked threads
+    ResourceGate gate;             // Old second resource lock, only with RESOURCE_GATE=1
+    
 public:
     // Reader tries to acquire the lock
     void read_lock() {
@@ -24,17 +38,15 @@ public:
         
         // If there's an active writer or waiting writers, readers should wait
         // This gives priority to writers to prevent their starvation
-        write_cv.wait(lock, [this] { 
+        waiting_readers++;
+        wait.wait(lock, read_cv, [this] { 
             return !writer_active && waiting_writers == 0; 
         });
+        waiting_readers--;
         
         // Increment the reader count
         reader_count++;
-        
-        // First reader acquires the resource lock
-        if (reader_count == 1) {
-            resource_mutex.lock();
-        }
+        if (reader_count == 1) gate.acquire();
         
         lock.unlock();
     }
@@ -45,12 +57,11 @@ public:
         
         // Decrement the reader count
         reader_count--;
+        if (reader_count == 0) gate.release();
         
-        // Last reader releases the resource lock
-        if (reader_count == 0) {
-            resource_mutex.unlock();
-            // Notify waiting writers that the resource is free
-            write_cv.notify_all();
+        // Last reader lets a writer in; only one can take over, so wake exactly one
+        if (reader_count == 0 && waiting_writers > 0) {
+            write_cv.notify_one();
         }
         
         lock.unlock();
@@ -64,7 +75,7 @@ public:
         waiting_writers++;
         
         // Wait until there are no active readers and no active writers
-        write_cv.wait(lock, [this] { 
+        wait.wait(lock, write_cv, [this] { 
             return reader_count == 0 && !writer_active; 
         });
         
@@ -73,9 +84,7 @@ public:
         waiting_writers--;
         
         lock.unlock();
-        
-        // Acquire exclusive access to the resource
-        resource_mutex.lock();
+        gate.acquire();
     }
     
     // Writer releases the lock
@@ -85,13 +94,24 @@ public:
         // Mark writer as inactive
         writer_active = false;
         
-        lock.unlock();
+        // Decide who to wake while the counts are still protected
+        bool wake_writer = waiting_writers > 0;
+        bool wake_readers = !wake_writer && waiting_readers > 0;
         
-        // Release exclusive access to the resource
-        resource_mutex.unlock();
+        lock.unlock();
+        gate.release();
         
-        // Notify waiting threads
-        write_cv.notify_all();
+        // Wake exactly one writer if one is waiting (writer priority), otherwise all readers
+        if (wake_writer) {
+            write_cv.notify_one();
+        } else if (wake_readers) {
+            read_cv.notify_all();
+        }
+    }
+    
+    // Print how the waits were resolved
+    void print_wait_stats() const {
+        wait.print_report();
     }
 };
 
@@ -100,18 +120,41 @@ class SharedResource {
 private:
     int data = 0;
     ReadersWriterLock rwlock;
+    WriteCombiner<ReadersWriterLock> combiner{rwlock};  // Batches writers when COMBINE_WRITES=1
     std::mutex print_mutex;  // For synchronized console output
     
+    // Apply a batch of combined or queued writes; runs with the write lock held, in the
+    // combining writer or in the async applier thread
+    void apply_batch(const std::vector<WriteCombiner<ReadersWriterLock>::Update>& batch) {
+        for (const auto& update : batch) {
+            {
+                std::lock_guard<std::mutex> print_lock(print_mutex);
+                std::cout << "Writer " << update.first << " is writing data: " << update.second
+                          << " (batch of " << batch.size() << ")" << std::endl;
+            }
+            data = update.second;
+        }
+        
+        // One simulated processing phase for the whole batch
+        std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
+    }
+    
+    // Applier thread for ASYNC_WRITES=1; declared last so it stops before the members it uses
+    AsyncWriteQueue<ReadersWriterLock> async_writes{rwlock, [this](const auto& batch) { apply_batch(batch); }};
+    
 public:
     // Reader function: reads data from the shared resource
-    void reader(int id) {
+    OpTiming reader(int id) {
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Reader " << id << " wants to read." << std::endl;
         }
         
         // Acquire read lock
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         rwlock.read_lock();
+        timing.granted = std::chrono::steady_clock::now();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
@@ -123,22 +166,60 @@ public:
         
         // Release read lock
         rwlock.read_unlock();
+        timing.released = std::chrono::steady_clock::now();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Reader " << id << " finished reading." << std::endl;
         }
+        
+        return timing;
+    }
+    
+    bool async_writes_enabled() const {
+        return async_writes.enabled();
+    }
+    
+    // Async writer function (ASYNC_WRITES=1): queues the update for the applier thread and
+    // returns at once; the future becomes ready when the update has been applied
+    std::future<void> writer_async(int id, OpTiming& timing) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " wants to write." << std::endl;
+        }
+        
+        timing.requested = std::chrono::steady_clock::now();
+        std::future<void> applied = async_writes.write(id, rand() % 1000);
+        timing.granted = timing.released = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " queued its update." << std::endl;
+        }
+        return applied;
     }
     
     // Writer function: modifies the shared resource
-    void writer(int id) {
+    OpTiming writer(int id) {
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Writer " << id << " wants to write." << std::endl;
         }
         
+        if (combiner.enabled()) {
+            // Publish the update and let a combining writer apply it
+            OpTiming timing = combiner.write(id, rand() % 1000, [this](const auto& batch) { apply_batch(batch); });
+            {
+                std::lock_guard<std::mutex> print_lock(print_mutex);
+                std::cout << "Writer " << id << " finished writing." << std::endl;
+            }
+            return timing;
+        }
+        
         // Acquire write lock
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         rwlock.write_lock();
+        timing.granted = std::chrono::steady_clock::now();
         
         // Simulate writing process
         int new_value = rand() % 1000;
@@ -156,11 +237,26 @@ public:
         
         // Release write lock
         rwlock.write_unlock();
+        timing.released = std::chrono::steady_clock::now();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Writer " << id << " finished writing." << std::endl;
         }
+        
+        return timing;
+    }
+    
+    // Wait until every queued async write has been applied
+    void flush_writes() {
+        async_writes.flush();
+    }
+    
+    // Print lock-internal statistics
+    void print_lock_stats() const {
+        async_writes.print_report();
+        combiner.print_report();
+        rwlock.print_wait_stats();
     }
 };
 
@@ -170,24 +266,51 @@ struct Statistics {
     std::atomic<int> total_writes{0};
     std::atomic<int> readers_waiting{0};
     std::atomic<int> writers_waiting{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("Writers-Priority", num_readers, num_writers, operations_per_thread) {}
 };
 
 int main() {
     // Seed for random number generation
     srand(static_cast<unsigned int>(time(nullptr)));
     
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<ReadersWriterLock>("Writers-Priority", "ReadersWriterLock");
+    }
+    
+    // WORKLOAD=map benchmarks a striped hash map built on this lock instead
+    if (map_workload_requested()) {
+        return run_map_benchmark<ReadersWriterLock>("Writers-Priority");
+    }
+    
+    // WORKLOAD=handoff measures reader-to-writer handoff latency (RESOURCE_GATE=1: old protocol)
+    if (handoff_workload_requested()) {
+        return run_handoff_benchmark<ReadersWriterLock>("Writers-Priority");
+    }
+    
     // Create shared resource
     SharedResource resource;
-    Statistics stats;
     
     // Create threads for readers and writers
     // Use environment variables if provided, otherwise use defaults
     const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
     const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
     const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 3;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
     
     std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
               << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
     
     std::vector<std::thread> threads;
     
@@ -196,37 +319,73 @@ int main() {
               << num_writers << " writers." << std::endl;
     
     // Lambda to simulate reader behavior with random intervals
-    auto reader_task = [&resource, &stats, operations_per_thread](int id) {
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
         
-        for (int i = 0; i < operations_per_thread; i++) {
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
             // Random delay before attempting to read
             std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
             
             stats.readers_waiting++;
-            resource.reader(id);
+            OpTiming timing = resource.reader(id);
             stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
             stats.total_reads++;
+            stats.fairness.record_read(id, timing);
         }
     };
     
     // Lambda to simulate writer behavior with random intervals
-    auto writer_task = [&resource, &stats, operations_per_thread](int id) {
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
         
-        for (int i = 0; i < operations_per_thread; i++) {
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        std::future<void> pending;   // Last async write, at most one in flight per writer
+        
+        for (int i = 0; run.keep_running(i); i++) {
             // Random delay before attempting to write
             std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
             
             stats.writers_waiting++;
-            resource.writer(id);
+            OpTiming timing;
+            if (resource.async_writes_enabled()) {
+                // Confirm the previous update was applied before queueing the next one
+                if (pending.valid()) pending.get();
+                pending = resource.writer_async(id, timing);
+            } else {
+                timing = resource.writer(id);
+            }
             stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
             stats.total_writes++;
+            stats.fairness.record_write(id, timing);
         }
+        
+        // Confirm that the last queued update has been applied as well
+        if (pending.valid()) pending.get();
     };
     
     // Start reader threads
@@ -240,11 +399,11 @@ int main() {
     }
     
     // Monitor thread for displaying statistics
-    std::thread monitor([&stats, num_readers, num_writers, operations_per_thread]() {
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
         int expected_operations = (num_readers + num_writers) * operations_per_thread;
         int total_operations = 0;
         
-        while (total_operations < expected_operations) {
+        while (!run.done(total_operations, expected_operations)) {
             std::this_thread::sleep_for(std::chrono::seconds(2));
             total_operations = stats.total_reads + stats.total_writes;
             
@@ -253,16 +412,21 @@ int main() {
             std::cout << "Completed writes: " << stats.total_writes << std::endl;
             std::cout << "Readers waiting: " << stats.readers_waiting << std::endl;
             std::cout << "Writers waiting: " << stats.writers_waiting << std::endl;
-            std::cout << "Progress: " << (total_operations * 100) / expected_operations << "%" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
         }
     });
     
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
     // Wait for all threads to complete
     for (auto& thread : threads) {
         if (thread.joinable()) {
             thread.join();
         }
     }
+    run.finish();
+    resource.flush_writes();
     
     if (monitor.joinable()) {
         monitor.join();
@@ -273,5 +437,11 @@ int main() {
     std::cout << "Total reads: " << stats.total_reads << std::endl;
     std::cout << "Total writes: " << stats.total_writes << std::endl;
     
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
     return 0;
 }
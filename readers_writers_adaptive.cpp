@@ -0,0 +1,596 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_map.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
+
+enum class AdmissionMode { READERS_PRIORITY, WRITERS_PRIORITY, PHASE_FAIR };
+
+// Self-tuning Readers-Writers lock
+// The admission policy is switched at runtime between the three classic choices:
+// - READERS_PRIORITY: readers enter whenever no writer is active
+// - WRITERS_PRIORITY: readers also wait while writers are waiting
+// - PHASE_FAIR:       each write is followed by a batch of the readers waiting for it
+// Arrivals, completions and wait times are collected over windows of ADAPT_WINDOW_MS.
+// At the end of every window the current mode is scored against ADAPT_OBJECTIVE
+// (throughput, writer_p99 or mean_wait); the lock then switches to the best-scoring mode,
+// re-trying modes whose score is stale or was measured under a different read/write mix
+// (judged only on windows with at least ADAPT_MIN_SAMPLES arrivals). A measured mode must
+// beat the current one by 10% before the lock switches to it.
+class AdaptiveReadersWriterLock {
+private:
+    struct ModeScore {
+        double score = 0;          // Lower is better
+        bool valid = false;
+        int age = 0;               // Windows since this mode was last measured
+    };
+    
+    std::mutex mtx;                // Protects the lock state and the window statistics
+    std::condition_variable read_cv;
+    std::condition_variable write_cv;
+    
+    int reader_count = 0;          // Number of active readers
+    bool writer_active = false;    // Flag to check if writer is active
+    int waiting_readers = 0;
+    int waiting_writers = 0;
+    
+    // Phase-fair batches: write_unlock releases every reader waiting at that moment
+    unsigned long read_generation = 0;
+    int batch_pending = 0;         // Released readers that have not entered yet
+    
+    std::atomic<AdmissionMode> mode{AdmissionMode::WRITERS_PRIORITY};
+    std::string objective;
+    std::chrono::milliseconds window_length;
+    int explore_after;             // Re-measure a mode after this many windows
+    int min_samples;               // Arrivals needed before a mix change resets the scores
+    
+    // Current window
+    std::chrono::steady_clock::time_point window_start = std::chrono::steady_clock::now();
+    int read_arrivals = 0;
+    int write_arrivals = 0;
+    int completed = 0;
+    double wait_sum_ms = 0;
+    std::vector<double> writer_waits_ms;
+    
+    ModeScore scores[3];
+    double mix_at_scoring = -1;    // Read share of arrivals when the scores were taken
+    std::atomic<int> switches{0};
+    int windows = 0;
+    
+    WaitStrategy wait;             // Spin-then-park policy for blocked threads
+    
+    static long long env_or(const char* name, long long fallback) {
+        return std::getenv(name) ? std::stoll(std::getenv(name)) : fallback;
+    }
+    
+    bool reader_may_enter(unsigned long generation) const {
+        if (writer_active) return false;
+        if (read_generation != generation) return true;  // Released as part of a batch
+        
+        switch (mode.load(std::memory_order_relaxed)) {
+        case AdmissionMode::READERS_PRIORITY:
+            return true;
+        case AdmissionMode::WRITERS_PRIORITY:
+        case AdmissionMode::PHASE_FAIR:
+            return waiting_writers == 0;
+        }
+        return true;
+    }
+    
+    bool writer_may_enter() const {
+        return reader_count == 0 && !writer_active && batch_pending == 0;
+    }
+    
+    // Score of the window that just ended under the current mode; lower is better
+    double window_score(double seconds) {
+        if (objective == "writer_p99") {
+            if (writer_waits_ms.empty()) return 0;
+            size_t index = std::min(writer_waits_ms.size() - 1, writer_waits_ms.size() * 99 / 100);
+            std::nth_element(writer_waits_ms.begin(), writer_waits_ms.begin() + index, writer_waits_ms.end());
+            return writer_waits_ms[index];
+        }
+        if (objective == "mean_wait") {
+            return completed > 0 ? wait_sum_ms / completed : 0;
+        }
+        return -completed / seconds;  // throughput: maximise
+    }
+    
+    // Close the measurement window if it has elapsed and pick the next mode; mtx held
+    void maybe_adapt() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - window_start < window_length) return;
+        
+        double seconds = std::chrono::duration<double>(now - window_start).count();
+        int current = static_cast<int>(mode.load(std::memory_order_relaxed));
+        double score = window_score(seconds);
+        ModeScore& entry = scores[current];
+        entry.score = entry.valid ? (entry.score + score) / 2 : score;
+        entry.valid = true;
+        for (int m = 0; m < 3; m++) {
+            scores[m].age = m == current ? 0 : scores[m].age + 1;
+        }
+        
+        // A different read/write mix makes the other modes' scores meaningless; tiny
+        // windows are too noisy to tell
+        int arrivals = read_arrivals + write_arrivals;
+        if (arrivals >= min_samples) {
+            double mix = static_cast<double>(read_arrivals) / arrivals;
+            if (mix_at_scoring >= 0 && std::abs(mix - mix_at_scoring) > 0.2) {
+                for (int m = 0; m < 3; m++) {
+                    if (m != current) scores[m].valid = false;
+                }
+            }
+            mix_at_scoring = mix;
+        }
+        
+        // Explore unmeasured or stale modes, otherwise exploit the best one
+        int next = current;
+        for (int m = 0; m < 3; m++) {
+            if (!scores[m].valid || scores[m].age > explore_after) {
+                next = m;
+                break;
+            }
+        }
+        if (next == current) {
+            // Only leave the current mode for a clear improvement, so noise does not flap it
+            double best = scores[current].score - std::abs(scores[current].score) * 0.1;
+            for (int m = 0; m < 3; m++) {
+                if (scores[m].score < best) {
+                    best = scores[m].score;
+                    next = m;
+                }
+            }
+        }
+        
+        if (next != current) {
+            mode.store(static_cast<AdmissionMode>(next), std::memory_order_relaxed);
+            switches++;
+            // The admission predicates changed for everybody
+            read_cv.notify_all();
+            write_cv.notify_all();
+        }
+        
+        windows++;
+        window_start = now;
+        read_arrivals = write_arrivals = completed = 0;
+        wait_sum_ms = 0;
+        writer_waits_ms.clear();
+    }
+    
+    static double ms_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    
+public:
+    AdaptiveReadersWriterLock()
+        : objective(std::getenv("ADAPT_OBJECTIVE") ? std::getenv("ADAPT_OBJECTIVE") : "throughput"),
+          window_length(env_or("ADAPT_WINDOW_MS", 2000)),
+          explore_after(static_cast<int>(env_or("ADAPT_EXPLORE", 8))),
+          min_samples(static_cast<int>(env_or("ADAPT_MIN_SAMPLES", 20))) {
+        if (objective != "throughput" && objective != "writer_p99" && objective != "mean_wait") {
+            std::cerr << "Unknown ADAPT_OBJECTIVE '" << objective << "', using throughput" << std::endl;
+            objective = "throughput";
+        }
+    }
+    
+    // Reader tries to acquire the lock under the current admission mode
+    void read_lock() {
+        std::unique_lock<std::mutex> lock(mtx);
+        auto start = std::chrono::steady_clock::now();
+        read_arrivals++;
+        
+        waiting_readers++;
+        unsigned long generation = read_generation;
+        wait.wait(lock, read_cv, [this, generation] { return reader_may_enter(generation); });
+        waiting_readers--;
+        if (read_generation != generation) batch_pending--;
+        
+        reader_count++;
+        wait_sum_ms += ms_since(start);
+    }
+    
+    // Reader releases the lock
+    void read_unlock() {
+        std::unique_lock<std::mutex> lock(mtx);
+        
+        reader_count--;
+        completed++;
+        
+        // Last reader lets one writer in
+        if (reader_count == 0 && waiting_writers > 0) {
+            write_cv.notify_one();
+        }
+        maybe_adapt();
+    }
+    
+    // Writer tries to acquire the lock
+    void write_lock() {
+        std::unique_lock<std::mutex> lock(mtx);
+        auto start = std::chrono::steady_clock::now();
+        write_arrivals++;
+        
+        waiting_writers++;
+        wait.wait(lock, write_cv, [this] { return writer_may_enter(); });
+        waiting_writers--;
+        
+        writer_active = true;
+        double waited = ms_since(start);
+        wait_sum_ms += waited;
+        writer_waits_ms.push_back(waited);
+    }
+    
+    // Writer releases the lock; who is woken depends on the current mode
+    void write_unlock() {
+        std::unique_lock<std::mutex> lock(mtx);
+        
+        writer_active = false;
+        completed++;
+        
+        switch (mode.load(std::memory_order_relaxed)) {
+        case AdmissionMode::READERS_PRIORITY:
+            read_cv.notify_all();
+            write_cv.notify_one();
+            break;
+        case AdmissionMode::WRITERS_PRIORITY:
+            if (waiting_writers > 0) {
+                write_cv.notify_one();
+            } else {
+                read_cv.notify_all();
+            }
+            break;
+        case AdmissionMode::PHASE_FAIR:
+            // Release every reader that waited for this write as one batch
+            if (waiting_readers > 0) {
+                read_generation++;
+                batch_pending = waiting_readers;
+                read_cv.notify_all();
+            } else {
+                write_cv.notify_one();
+            }
+            break;
+        }
+        maybe_adapt();
+    }
+    
+    static const char* mode_name(AdmissionMode m) {
+        switch (m) {
+        case AdmissionMode::READERS_PRIORITY: return "readers-priority";
+        case AdmissionMode::WRITERS_PRIORITY: return "writers-priority";
+        case AdmissionMode::PHASE_FAIR: return "phase-fair";
+        }
+        return "unknown";
+    }
+    
+    // Current mode and switch count; lock-free, safe to poll from the monitor thread
+    const char* current_mode() const {
+        return mode_name(mode.load(std::memory_order_relaxed));
+    }
+    
+    int switch_count() const {
+        return switches.load(std::memory_order_relaxed);
+    }
+    
+    // Print the tuning state and how the waits were resolved
+    void print_wait_stats() const {
+        std::cout << "\n----- ADAPTIVE POLICY -----" << std::endl;
+        std::cout << "Objective: " << objective << " (window " << window_length.count() << " ms)" << std::endl;
+        std::cout << "Final mode: " << current_mode() << std::endl;
+        std::cout << "Mode switches: " << switch_count() << " in " << windows << " windows" << std::endl;
+        for (int m = 0; m < 3; m++) {
+            std::cout << "Score " << mode_name(static_cast<AdmissionMode>(m)) << ": ";
+            if (scores[m].valid) {
+                std::cout << (objective == "throughput" ? -scores[m].score : scores[m].score) << std::endl;
+            } else {
+                std::cout << "not measured" << std::endl;
+            }
+        }
+        wait.print_report();
+    }
+};
+
+// Shared resource (simulated as an integer)
+class SharedResource {
+private:
+    int data = 0;
+    AdaptiveReadersWriterLock rwlock;
+    std::mutex print_mutex;  // For synchronized console output
+    
+public:
+    // Reader function: reads data from the shared resource
+    OpTiming reader(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " wants to read." << std::endl;
+        }
+        
+        // Acquire read lock
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        rwlock.read_lock();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " is reading data: " << data 
+                      << " (waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Simulate reading process
+        std::this_thread::sleep_for(std::chrono::milliseconds(100 + (rand() % 900)));
+        
+        // Release read lock
+        rwlock.read_unlock();
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " finished reading." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Writer function: modifies the shared resource
+    OpTiming writer(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " wants to write." << std::endl;
+        }
+        
+        // Acquire write lock
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        rwlock.write_lock();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        // Simulate writing process
+        int new_value = rand() % 1000;
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " is writing data: " << new_value 
+                      << " (waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Modify the shared data
+        data = new_value;
+        
+        // Simulate additional processing
+        std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
+        
+        // Release write lock
+        rwlock.write_unlock();
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " finished writing." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Get the current data value
+    int get_data() const {
+        return data;
+    }
+    
+    // Current admission mode of the lock
+    const char* lock_mode() const {
+        return rwlock.current_mode();
+    }
+    
+    int lock_switches() const {
+        return rwlock.switch_count();
+    }
+    
+    // Print lock-internal statistics
+    void print_lock_stats() const {
+        rwlock.print_wait_stats();
+    }
+};
+
+// Statistics for the demonstration
+struct Statistics {
+    std::atomic<int> total_reads{0};
+    std::atomic<int> total_writes{0};
+    std::atomic<int> readers_waiting{0};
+    std::atomic<int> writers_waiting{0};
+    std::atomic<long long> reader_wait_time{0};
+    std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("Adaptive", num_readers, num_writers, operations_per_thread) {}
+};
+
+int main() {
+    // Seed for random number generation
+    srand(static_cast<unsigned int>(time(nullptr)));
+    
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<AdaptiveReadersWriterLock>("Adaptive", "AdaptiveReadersWriterLock", "recent writer wait samples for the admission policy");
+    }
+    
+    // WORKLOAD=map benchmarks a striped hash map built on this lock instead
+    if (map_workload_requested()) {
+        return run_map_benchmark<AdaptiveReadersWriterLock>("Adaptive");
+    }
+    
+    // Create shared resource
+    SharedResource resource;
+    
+    // Create threads for readers and writers
+    // Use environment variables if provided, otherwise use defaults
+    const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
+    const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
+    const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
+    
+    std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
+              << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
+    
+    std::vector<std::thread> threads;
+    
+    std::cout << "Starting readers-writers demonstration (ADAPTIVE POLICY) with "
+              << num_readers << " readers and " 
+              << num_writers << " writers." << std::endl;
+    
+    // Lambda to simulate reader behavior with random intervals
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to read
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.readers_waiting++;
+            OpTiming timing = resource.reader(id);
+            stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_reads++;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
+        }
+    };
+    
+    // Lambda to simulate writer behavior with random intervals
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to write
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.writers_waiting++;
+            OpTiming timing = resource.writer(id);
+            stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_writes++;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
+        }
+    };
+    
+    // Start reader threads
+    for (int i = 0; i < num_readers; i++) {
+        threads.emplace_back(reader_task, i + 1);
+    }
+    
+    // Start writer threads
+    for (int i = 0; i < num_writers; i++) {
+        threads.emplace_back(writer_task, i + 1);
+    }
+    
+    // Monitor thread for displaying statistics
+    std::thread monitor([&resource, &stats, &run, num_readers, num_writers, operations_per_thread]() {
+        int expected_operations = (num_readers + num_writers) * operations_per_thread;
+        int total_operations = 0;
+        
+        while (!run.done(total_operations, expected_operations)) {
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            total_operations = stats.total_reads + stats.total_writes;
+            
+            std::cout << "\n----- STATISTICS -----" << std::endl;
+            std::cout << "Completed reads: " << stats.total_reads << std::endl;
+            std::cout << "Completed writes: " << stats.total_writes << std::endl;
+            std::cout << "Readers waiting: " << stats.readers_waiting << std::endl;
+            std::cout << "Writers waiting: " << stats.writers_waiting << std::endl;
+            
+            // Calculate average wait times
+            float avg_reader_wait = stats.total_reads > 0 ? 
+                                     static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+            float avg_writer_wait = stats.total_writes > 0 ? 
+                                     static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+            
+            std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+            std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+            std::cout << "Lock mode: " << resource.lock_mode() << " (" << resource.lock_switches() << " switches)" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
+        }
+    });
+    
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
+    // Wait for all threads to complete
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    run.finish();
+    
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+    
+    std::cout << "\nDemonstration completed!" << std::endl;
+    std::cout << "Final statistics:" << std::endl;
+    std::cout << "Total reads: " << stats.total_reads << std::endl;
+    std::cout << "Total writes: " << stats.total_writes << std::endl;
+    
+    // Calculate final average wait times
+    float avg_reader_wait = stats.total_reads > 0 ? 
+                             static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+    float avg_writer_wait = stats.total_writes > 0 ? 
+                             static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+    
+    std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+    std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+    
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
+    return 0;
+}
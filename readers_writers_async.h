@@ -0,0 +1,209 @@
+/**
+ * readers_writers_async.h - Asynchronous single-writer update queue
+ *
+ * With ASYNC_WRITES=1 a writer does not take the lock at all: it pushes its update onto a
+ * lock-free multi-producer/single-consumer queue and gets a std::future that becomes ready
+ * once the update has been applied. One applier thread drains the queue and applies each
+ * batch under a single exclusive acquisition, so writer latency becomes the cost of an
+ * enqueue and readers wait behind far fewer exclusive phases. Readers are unchanged.
+ *
+ * The queue is the intrusive MPSC design by Dmitry Vyukov: producers swing `head` with one
+ * atomic exchange and link the previous node; the single consumer follows `next` pointers
+ * from `tail`. The applier sleeps on a condition variable when the queue is empty and
+ * producers only touch that mutex when the applier is actually asleep.
+ *
+ * The lock type only needs write_lock()/write_unlock().
+ */
+
+#ifndef READERS_WRITERS_ASYNC_H
+#define READERS_WRITERS_ASYNC_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template <typename Lock>
+class AsyncWriteQueue {
+public:
+    using Update = std::pair<int, int>;  // Writer id, value
+    using ApplyBatch = std::function<void(const std::vector<Update>&)>;
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        Update update;
+        std::promise<void> applied;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    Lock& lock;
+    ApplyBatch apply_batch;
+    bool active;
+    size_t max_batch;
+
+    // MPSC queue: producers push at head, the applier pops at tail; `stub` keeps it non-empty
+    std::atomic<Node*> head;
+    Node* tail;
+    Node stub;
+
+    std::atomic<bool> applier_sleeping{false};
+    std::atomic<bool> stopping{false};
+    std::mutex sleep_mtx;
+    std::condition_variable wake_cv;
+    std::condition_variable drained_cv;
+
+    std::atomic<long long> enqueued_count{0};
+    std::atomic<long long> applied_count{0};
+    long long batches = 0;               // Applier thread only
+    size_t largest_batch = 0;
+    double total_latency_ms = 0;         // Enqueue -> applied, summed over all updates
+
+    std::thread applier;
+
+    void push(Node* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // Single consumer; returns nullptr when empty or when a producer is mid-push
+    Node* pop() {
+        Node* first = tail;
+        Node* next = first->next.load(std::memory_order_acquire);
+        if (first == &stub) {
+            if (next == nullptr) return nullptr;
+            tail = next;
+            first = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail = next;
+            return first;
+        }
+        if (first != head.load(std::memory_order_acquire)) return nullptr;  // Push in progress
+        push(&stub);
+        next = first->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail = next;
+            return first;
+        }
+        return nullptr;
+    }
+
+    void run() {
+        std::vector<Node*> nodes;
+        std::vector<Update> batch;
+        for (;;) {
+            nodes.clear();
+            while (nodes.size() < max_batch) {
+                Node* node = pop();
+                if (node == nullptr) break;
+                nodes.push_back(node);
+            }
+
+            if (nodes.empty()) {
+                if (stopping && applied_count == enqueued_count) return;
+                // Announce the sleep, then re-check so a concurrent push cannot be missed;
+                // the timeout covers a producer that is between its exchange and its link
+                std::unique_lock<std::mutex> guard(sleep_mtx);
+                applier_sleeping = true;
+                if (tail->next.load(std::memory_order_acquire) == nullptr && !stopping) {
+                    wake_cv.wait_for(guard, std::chrono::milliseconds(10));
+                }
+                applier_sleeping = false;
+                continue;
+            }
+
+            batch.clear();
+            for (Node* node : nodes) batch.push_back(node->update);
+
+            lock.write_lock();
+            apply_batch(batch);
+            lock.write_unlock();
+
+            auto now = std::chrono::steady_clock::now();
+            for (Node* node : nodes) {
+                total_latency_ms += std::chrono::duration<double, std::milli>(now - node->enqueued).count();
+                node->applied.set_value();
+                delete node;
+            }
+            batches++;
+            largest_batch = std::max(largest_batch, nodes.size());
+
+            {
+                std::lock_guard<std::mutex> guard(sleep_mtx);
+                applied_count += nodes.size();
+            }
+            drained_cv.notify_all();
+        }
+    }
+
+public:
+    AsyncWriteQueue(Lock& lock, ApplyBatch apply_batch)
+        : lock(lock), apply_batch(std::move(apply_batch)),
+          active(std::getenv("ASYNC_WRITES") && std::string(std::getenv("ASYNC_WRITES")) != "0"),
+          max_batch(std::getenv("ASYNC_BATCH") ? std::stoul(std::getenv("ASYNC_BATCH")) : 64),
+          head(&stub), tail(&stub) {
+        if (active) applier = std::thread(&AsyncWriteQueue::run, this);
+    }
+
+    ~AsyncWriteQueue() {
+        stopping = true;
+        {
+            std::lock_guard<std::mutex> guard(sleep_mtx);
+            wake_cv.notify_one();
+        }
+        if (applier.joinable()) applier.join();
+    }
+
+    bool enabled() const {
+        return active;
+    }
+
+    // Queue an update; the future becomes ready once it has been applied under the lock
+    std::future<void> write(int id, int value) {
+        Node* node = new Node;
+        node->update = {id, value};
+        node->enqueued = std::chrono::steady_clock::now();
+        std::future<void> applied = node->applied.get_future();
+
+        enqueued_count++;
+        push(node);
+        if (applier_sleeping.load()) {
+            std::lock_guard<std::mutex> guard(sleep_mtx);
+            wake_cv.notify_one();
+        }
+        return applied;
+    }
+
+    // Block until every update queued so far has been applied
+    void flush() {
+        if (!active) return;
+        std::unique_lock<std::mutex> guard(sleep_mtx);
+        drained_cv.wait(guard, [this] { return applied_count == enqueued_count; });
+    }
+
+    // Must be called after flush()
+    void print_report() const {
+        if (!active) return;
+        std::cout << "\n----- ASYNC WRITE QUEUE -----" << std::endl;
+        std::cout << "Exclusive acquisitions: " << batches << " for " << applied_count << " writes" << std::endl;
+        std::cout << "Writes per acquisition (avg/max): "
+                  << (batches > 0 ? static_cast<double>(applied_count) / batches : 0.0)
+                  << " / " << largest_batch << std::endl;
+        std::cout << "Avg enqueue-to-applied latency: "
+                  << (applied_count > 0 ? total_latency_ms / applied_count : 0.0) << " ms" << std::endl;
+    }
+};
+
+#endif // READERS_WRITERS_ASYNC_H
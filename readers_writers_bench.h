@@ -0,0 +1,403 @@
+/**
+ * readers_writers_bench.h - Shared benchmark instrumentation for the Readers-Writers demos
+ *
+ * Every implementation keeps its own lock, SharedResource and main(); this header only
+ * holds the measurement code so that all variants report the same metrics in the same
+ * format and can be compared line by line by readers_writers_demo.sh.
+ */
+
+#ifndef READERS_WRITERS_BENCH_H
+#define READERS_WRITERS_BENCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Timing of a single read or write, captured by SharedResource around the lock call
+struct OpTiming {
+    std::chrono::steady_clock::time_point requested;  // Just before read_lock()/write_lock()
+    std::chrono::steady_clock::time_point granted;    // Just after the lock was acquired
+    std::chrono::steady_clock::time_point released;   // Just after the lock was released
+
+    long long wait_ms() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(granted - requested).count();
+    }
+
+    long long wait_us() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(granted - requested).count();
+    }
+};
+
+// Tracks per-thread service so starvation can be quantified rather than guessed at.
+// Each thread only ever writes its own slot, so recording needs no synchronization;
+// the report must be produced after all worker threads have been joined.
+class FairnessTracker {
+private:
+    struct Sample {
+        long long requested_ns;
+        long long granted_ns;
+    };
+
+    // Padded so that two threads never write to the same cache line
+    struct alignas(64) ThreadSlot {
+        int completed = 0;
+        long long total_wait_us = 0;
+        long long max_wait_us = 0;
+        std::vector<Sample> samples;
+    };
+
+    std::vector<ThreadSlot> reader_slots;
+    std::vector<ThreadSlot> writer_slots;
+
+    static long long to_ns(std::chrono::steady_clock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    static void record(ThreadSlot& slot, const OpTiming& timing) {
+        long long wait_us = timing.wait_us();
+        slot.completed++;
+        slot.total_wait_us += wait_us;
+        slot.max_wait_us = std::max(slot.max_wait_us, wait_us);
+        slot.samples.push_back({to_ns(timing.requested), to_ns(timing.granted)});
+    }
+
+    static std::vector<Sample> collect(const std::vector<ThreadSlot>& slots) {
+        std::vector<Sample> all;
+        for (const auto& slot : slots) {
+            all.insert(all.end(), slot.samples.begin(), slot.samples.end());
+        }
+        return all;
+    }
+
+    // Jain's fairness index: (sum x)^2 / (n * sum x^2). 1.0 means perfectly even,
+    // 1/n means a single thread received everything.
+    static double jain_index(const std::vector<double>& values) {
+        double sum = 0, sum_sq = 0;
+        for (double v : values) {
+            sum += v;
+            sum_sq += v * v;
+        }
+        if (values.empty() || sum_sq == 0) return 1.0;
+        return (sum * sum) / (values.size() * sum_sq);
+    }
+
+    // Counts how often a victim was overtaken: pairs where the bypasser requested the
+    // lock after the victim but was granted it before the victim. Victims and bypassers
+    // are swept in grant order while a Fenwick tree over request times answers "how many
+    // already-granted bypassers requested later than this victim" in O(log n).
+    static long long count_bypasses(std::vector<Sample> victims, std::vector<Sample> bypassers,
+                                    long long& worst) {
+        worst = 0;
+        if (victims.empty() || bypassers.empty()) return 0;
+
+        auto by_grant = [](const Sample& a, const Sample& b) { return a.granted_ns < b.granted_ns; };
+        std::sort(victims.begin(), victims.end(), by_grant);
+        std::sort(bypassers.begin(), bypassers.end(), by_grant);
+
+        std::vector<long long> request_times;
+        for (const auto& s : bypassers) request_times.push_back(s.requested_ns);
+        std::sort(request_times.begin(), request_times.end());
+        request_times.erase(std::unique(request_times.begin(), request_times.end()), request_times.end());
+
+        std::vector<int> tree(request_times.size() + 1, 0);
+        int inserted = 0;
+        auto insert = [&](long long requested_ns) {
+            size_t i = std::lower_bound(request_times.begin(), request_times.end(), requested_ns)
+                       - request_times.begin() + 1;
+            for (; i < tree.size(); i += i & -i) tree[i]++;
+            inserted++;
+        };
+        auto count_not_after = [&](long long requested_ns) {
+            int count = 0;
+            size_t i = std::upper_bound(request_times.begin(), request_times.end(), requested_ns)
+                       - request_times.begin();
+            for (; i > 0; i -= i & -i) count += tree[i];
+            return count;
+        };
+
+        long long total = 0;
+        size_t next = 0;
+        for (const auto& victim : victims) {
+            while (next < bypassers.size() && bypassers[next].granted_ns < victim.granted_ns) {
+                insert(bypassers[next++].requested_ns);
+            }
+            long long overtaken = inserted - count_not_after(victim.requested_ns);
+            total += overtaken;
+            worst = std::max(worst, overtaken);
+        }
+        return total;
+    }
+
+    static void print_side(const char* label, const std::vector<ThreadSlot>& slots) {
+        std::vector<double> ops, mean_wait;
+        int min_ops = slots.empty() ? 0 : slots.front().completed;
+        int max_ops = min_ops;
+        long long max_wait_us = 0;
+        size_t max_wait_thread = 0;
+
+        for (size_t i = 0; i < slots.size(); i++) {
+            const ThreadSlot& slot = slots[i];
+            ops.push_back(slot.completed);
+            mean_wait.push_back(slot.completed > 0 ?
+                                static_cast<double>(slot.total_wait_us) / slot.completed : 0);
+            min_ops = std::min(min_ops, slot.completed);
+            max_ops = std::max(max_ops, slot.completed);
+            if (slot.max_wait_us > max_wait_us) {
+                max_wait_us = slot.max_wait_us;
+                max_wait_thread = i + 1;
+            }
+        }
+
+        std::cout << "Longest wait for a " << label << ": " << max_wait_us / 1000.0 << " ms";
+        if (max_wait_thread > 0) std::cout << " (thread " << max_wait_thread << ")";
+        std::cout << std::endl;
+        std::cout << "Ops per " << label << " thread (min/max): " << min_ops << " / " << max_ops << std::endl;
+        std::cout << "Jain's index (" << label << " ops): " << jain_index(ops) << std::endl;
+        std::cout << "Jain's index (" << label << " mean wait): " << jain_index(mean_wait) << std::endl;
+    }
+
+public:
+    FairnessTracker(int num_readers, int num_writers, int expected_ops_per_thread = 0)
+        : reader_slots(num_readers), writer_slots(num_writers) {
+        for (auto& slot : reader_slots) slot.samples.reserve(expected_ops_per_thread);
+        for (auto& slot : writer_slots) slot.samples.reserve(expected_ops_per_thread);
+    }
+
+    // Thread ids are 1-based, matching the ids printed by the demos
+    void record_read(int id, const OpTiming& timing) {
+        record(reader_slots[id - 1], timing);
+    }
+
+    void record_write(int id, const OpTiming& timing) {
+        record(writer_slots[id - 1], timing);
+    }
+
+    // Print the fairness section of the final statistics
+    void print_report() const {
+        std::vector<Sample> reads = collect(reader_slots);
+        std::vector<Sample> writes = collect(writer_slots);
+        long long worst_write = 0, worst_read = 0;
+        long long writer_bypasses = count_bypasses(writes, reads, worst_write);
+        long long reader_bypasses = count_bypasses(reads, writes, worst_read);
+
+        std::cout << "\n----- FAIRNESS -----" << std::endl;
+        print_side("reader", reader_slots);
+        print_side("writer", writer_slots);
+        std::cout << "Writers overtaken by later readers: " << writer_bypasses
+                  << " (worst single write: " << worst_write << ")" << std::endl;
+        std::cout << "Readers overtaken by later writers: " << reader_bypasses
+                  << " (worst single read: " << worst_read << ")" << std::endl;
+    }
+};
+
+// Phases of a benchmark run. All workers wait at a start barrier so that nobody runs
+// uncontended while later threads are still being created. In timed mode (DURATION set)
+// the run then goes through a warm-up, a fixed measurement window and a drain phase,
+// and only operations that complete inside the window are counted. Without DURATION
+// every thread performs OPERATIONS operations and everything counts, as before.
+class BenchmarkRun {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    int parties;                     // Workers plus the controlling main thread
+    int operations_per_thread;
+    double warmup_seconds;
+    double duration_seconds;         // 0 means fixed-operation mode
+
+    mutable std::mutex barrier_mutex;        // Also guards start_time for the monitor thread
+    std::condition_variable barrier_cv;
+    int arrived = 0;
+    bool started = false;
+    std::atomic<bool> stop_flag{false};
+
+    Clock::time_point start_time;
+    Clock::time_point window_start;
+    Clock::time_point window_end;
+    Clock::time_point finish_time;
+
+    static double env_seconds(const char* name, double fallback) {
+        return std::getenv(name) ? std::stod(std::getenv(name)) : fallback;
+    }
+
+    static Clock::duration seconds(double s) {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(s));
+    }
+
+public:
+    BenchmarkRun(int num_workers, int operations_per_thread)
+        : parties(num_workers + 1), operations_per_thread(operations_per_thread),
+          warmup_seconds(0), duration_seconds(env_seconds("DURATION", 0)) {
+        if (timed()) {
+            warmup_seconds = env_seconds("WARMUP", 1.0);
+        }
+    }
+
+    bool timed() const {
+        return duration_seconds > 0;
+    }
+
+    void print_configuration() const {
+        if (timed()) {
+            std::cout << "Run mode: timed (warm-up " << warmup_seconds << " s, measurement window "
+                      << duration_seconds << " s)" << std::endl;
+        } else {
+            std::cout << "Run mode: " << operations_per_thread << " operations per thread" << std::endl;
+        }
+    }
+
+    // Start barrier: workers block here until every worker and the controller have arrived.
+    // The last thread to arrive fixes the phase boundaries for everybody.
+    void wait_for_start() {
+        std::unique_lock<std::mutex> lock(barrier_mutex);
+        if (++arrived == parties) {
+            start_time = Clock::now();
+            window_start = start_time + seconds(warmup_seconds);
+            window_end = window_start + seconds(duration_seconds);
+            started = true;
+            barrier_cv.notify_all();
+        } else {
+            barrier_cv.wait(lock, [this] { return started; });
+        }
+    }
+
+    // Called by main() once all workers have been created: releases the start barrier and,
+    // in timed mode, sleeps through warm-up and the measurement window before raising the
+    // stop flag. Workers then drain by finishing their in-flight operation.
+    void start() {
+        wait_for_start();
+        if (!timed()) return;
+
+        std::this_thread::sleep_until(window_start);
+        std::cout << "\n----- WARM-UP FINISHED, MEASURING -----" << std::endl;
+        std::this_thread::sleep_until(window_end);
+        stop_flag = true;
+        std::cout << "\n----- MEASUREMENT WINDOW CLOSED, DRAINING -----" << std::endl;
+    }
+
+    // Called by main() after all workers have been joined
+    void finish() {
+        finish_time = Clock::now();
+    }
+
+    // Whether a worker that has completed `completed` operations should issue another one
+    bool keep_running(int completed) const {
+        return timed() ? !stop_flag : completed < operations_per_thread;
+    }
+
+    bool stopped() const {
+        return stop_flag;
+    }
+
+    // Only operations that complete inside the measurement window count
+    bool in_window(const OpTiming& timing) const {
+        return !timed() || (timing.released >= window_start && timing.released < window_end);
+    }
+
+    // Whether the monitor thread can stop printing progress
+    bool done(int total_operations, int expected_operations) const {
+        return timed() ? stop_flag.load() : total_operations >= expected_operations;
+    }
+
+    int progress_percent(int total_operations, int expected_operations) const {
+        if (!timed()) {
+            return expected_operations > 0 ? (total_operations * 100) / expected_operations : 100;
+        }
+        // The monitor never passes the start barrier, so it reads start_time under its mutex
+        Clock::time_point started_at;
+        {
+            std::lock_guard<std::mutex> lock(barrier_mutex);
+            if (!started) return 0;
+            started_at = start_time;
+        }
+        double elapsed = std::chrono::duration<double>(Clock::now() - started_at).count();
+        return std::min(100, static_cast<int>(elapsed * 100 / (warmup_seconds + duration_seconds)));
+    }
+
+    // Length of the period the counters refer to
+    double measured_seconds() const {
+        if (timed()) return duration_seconds;
+        return std::chrono::duration<double>(finish_time - start_time).count();
+    }
+
+    void print_report(int total_reads, int total_writes) const {
+        double elapsed = measured_seconds();
+        std::cout << "Measured period: " << elapsed << " s" << (timed() ? " (steady-state window)" : "")
+                  << std::endl;
+        if (elapsed > 0) {
+            std::cout << "Throughput: " << (total_reads + total_writes) / elapsed << " ops/s ("
+                      << total_reads / elapsed << " reads/s, " << total_writes / elapsed << " writes/s)"
+                      << std::endl;
+        }
+    }
+};
+
+// Lock state as seen by monitoring code
+struct LockState {
+    int active_readers = 0;
+    bool writer_active = false;
+    int waiting_readers = 0;
+    int waiting_writers = 0;
+    int queue_depth = 0;
+};
+
+// Lock state published for monitoring without touching the lock's mutex. The lock stores
+// a packed copy (one 64-bit word) whenever its state changes, while it already holds its
+// own mutex; pollers load it with a single atomic read and never take that mutex. The word
+// is not padded to its own cache line: that would make every lock embedding it 64-byte
+// aligned, and a poller only reads the line. Counts saturate at 65535 (readers at 32767),
+// which is plenty for a dashboard.
+class LockStateSnapshot {
+private:
+    std::atomic<uint64_t> packed{0};
+
+    static uint64_t clamp(int value, int max) {
+        return static_cast<uint64_t>(std::min(std::max(value, 0), max));
+    }
+
+public:
+    void publish(const LockState& state) {
+        uint64_t word = clamp(state.active_readers, 0x7FFF)
+                      | static_cast<uint64_t>(state.writer_active) << 15
+                      | clamp(state.waiting_readers, 0xFFFF) << 16
+                      | clamp(state.waiting_writers, 0xFFFF) << 32
+                      | clamp(state.queue_depth, 0xFFFF) << 48;
+        packed.store(word, std::memory_order_release);
+    }
+
+    LockState load() const {
+        uint64_t word = packed.load(std::memory_order_acquire);
+        LockState state;
+        state.active_readers = word & 0x7FFF;
+        state.writer_active = (word >> 15) & 1;
+        state.waiting_readers = (word >> 16) & 0xFFFF;
+        state.waiting_writers = (word >> 32) & 0xFFFF;
+        state.queue_depth = (word >> 48) & 0xFFFF;
+        return state;
+    }
+};
+
+// WORKLOAD=sizes: the program only reports the footprint of its lock and exits, so
+// readers_writers_demo.sh --sizes can tabulate the per-lock overhead of every variant
+inline bool footprint_requested() {
+    return std::getenv("WORKLOAD") && std::string(std::getenv("WORKLOAD")) == "sizes";
+}
+
+// `type` names the lock class in the report; `note` describes memory that sizeof misses
+template <typename Lock>
+int print_lock_footprint(const char* policy, const char* type, const std::string& note = "") {
+    std::cout << "\n----- LOCK FOOTPRINT -----" << std::endl;
+    std::cout << "Lock policy: " << policy << std::endl;
+    std::cout << "Lock size: " << sizeof(Lock) << " bytes, alignment " << alignof(Lock) << " (" << type << ")" << std::endl;
+    if (!note.empty()) std::cout << "Additional memory: " << note << std::endl;
+    return 0;
+}
+
+#endif // READERS_WRITERS_BENCH_H
@@ -0,0 +1,490 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_map.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
+
+// NUMA-aware cohort Readers-Writers lock
+// Every NUMA node has its own local lock and reader counter, so readers only ever touch
+// memory of their own node. Writers first take their node's local lock and then the global
+// lock; once a node owns the global lock it passes it directly to other writers of the same
+// node for a bounded number of handoffs before releasing it, which keeps the write side and
+// the protected data on one socket instead of bouncing them between sockets.
+// On machines without NUMA the lock degenerates to a single node.
+class CohortReadersWriterLock {
+private:
+    // Per-node state, padded so that nodes never share a cache line
+    struct alignas(64) Node {
+        std::mutex mtx;                    // Protects the fields below
+        std::condition_variable read_cv;   // Readers waiting for the write side to clear
+        std::condition_variable drain_cv;  // A writer waiting for this node's readers to leave
+        std::condition_variable write_cv;  // Local writers waiting for the local lock
+        
+        int active_readers = 0;            // Readers of this node inside the critical section
+        bool writer_present = false;       // A writer (from any node) owns the global lock
+        bool local_writer = false;         // A writer of this node holds the local lock
+        int waiting_writers = 0;           // Writers of this node waiting for the local lock
+        bool owns_global = false;          // Global lock is kept by this node between handoffs
+        int handoffs = 0;                  // Consecutive local handoffs of the global lock
+    };
+    
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::vector<int> cpu_to_node;          // CPU id -> index into nodes
+    int max_handoffs;                      // Local handoffs before the global lock is released
+    
+    std::mutex global_mtx;                 // Protects global_held
+    std::condition_variable global_cv;     // Cohorts waiting for the global lock
+    bool global_held = false;              // Some node owns the write side
+    
+    std::atomic<long long> global_acquisitions{0};
+    std::atomic<long long> local_handoffs{0};
+    
+    WaitStrategy wait;                     // Spin-then-park policy for blocked threads
+    
+    // Node of the calling thread, looked up once per thread. Pinned threads (PLACEMENT)
+    // always map to their own node; floating threads use wherever they first ran.
+    Node& my_node() {
+        thread_local int cpu = -1;
+        if (cpu < 0) {
+#ifdef __linux__
+            cpu = sched_getcpu();
+#endif
+            if (cpu < 0) cpu = 0;
+        }
+        int index = cpu < static_cast<int>(cpu_to_node.size()) ? cpu_to_node[cpu] : 0;
+        return *nodes[index];
+    }
+    
+    // Take the global lock and close every node to new readers, then wait for
+    // readers already inside to leave
+    void acquire_global() {
+        {
+            std::unique_lock<std::mutex> lock(global_mtx);
+            wait.wait(lock, global_cv, [this] { return !global_held; });
+            global_held = true;
+        }
+        global_acquisitions++;
+        
+        for (auto& node : nodes) {
+            std::unique_lock<std::mutex> lock(node->mtx);
+            node->writer_present = true;
+            wait.wait(lock, node->drain_cv, [&node] { return node->active_readers == 0; });
+        }
+    }
+    
+    // Reopen every node to readers and hand the global lock to another cohort
+    void release_global() {
+        for (auto& node : nodes) {
+            std::lock_guard<std::mutex> lock(node->mtx);
+            node->writer_present = false;
+            node->read_cv.notify_all();
+        }
+        
+        std::lock_guard<std::mutex> lock(global_mtx);
+        global_held = false;
+        global_cv.notify_one();
+    }
+    
+public:
+    CohortReadersWriterLock()
+        : max_handoffs(std::getenv("COHORT_HANDOFFS") ? std::stoi(std::getenv("COHORT_HANDOFFS")) : 16) {
+        CpuTopology topology;
+        
+        // Map NUMA node ids (which need not be contiguous) onto node slots
+        std::vector<int> node_ids;
+        for (const auto& cpu : topology.all()) {
+            if (std::find(node_ids.begin(), node_ids.end(), cpu.node) == node_ids.end()) {
+                node_ids.push_back(cpu.node);
+            }
+        }
+        if (node_ids.empty()) node_ids.push_back(0);
+        for (size_t i = 0; i < node_ids.size(); i++) {
+            nodes.push_back(std::make_unique<Node>());
+        }
+        
+        for (const auto& cpu : topology.all()) {
+            if (cpu.id >= static_cast<int>(cpu_to_node.size())) cpu_to_node.resize(cpu.id + 1, 0);
+            cpu_to_node[cpu.id] = std::find(node_ids.begin(), node_ids.end(), cpu.node) - node_ids.begin();
+        }
+    }
+    
+    // Reader tries to acquire the lock - only the local node is touched
+    void read_lock() {
+        Node& node = my_node();
+        std::unique_lock<std::mutex> lock(node.mtx);
+        
+        // Wait while a writer owns the global lock
+        wait.wait(lock, node.read_cv, [&node] { return !node.writer_present; });
+        node.active_readers++;
+    }
+    
+    // Reader releases the lock
+    void read_unlock() {
+        Node& node = my_node();
+        std::lock_guard<std::mutex> lock(node.mtx);
+        
+        // Last reader of this node lets a draining writer proceed
+        if (--node.active_readers == 0 && node.writer_present) {
+            node.drain_cv.notify_one();
+        }
+    }
+    
+    // Writer tries to acquire the lock: local lock first, then the global lock unless
+    // the previous local writer handed it over
+    void write_lock() {
+        Node& node = my_node();
+        std::unique_lock<std::mutex> lock(node.mtx);
+        
+        node.waiting_writers++;
+        wait.wait(lock, node.write_cv, [&node] { return !node.local_writer; });
+        node.waiting_writers--;
+        node.local_writer = true;
+        
+        if (node.owns_global) {
+            // Handoff from a writer of the same node: readers are still shut out
+            local_handoffs++;
+            return;
+        }
+        
+        lock.unlock();
+        acquire_global();
+        lock.lock();
+        node.owns_global = true;
+    }
+    
+    // Writer releases the lock: pass it on locally while the handoff budget lasts
+    void write_unlock() {
+        Node& node = my_node();
+        std::unique_lock<std::mutex> lock(node.mtx);
+        
+        node.local_writer = false;
+        if (node.waiting_writers > 0 && node.handoffs < max_handoffs) {
+            node.handoffs++;
+            node.write_cv.notify_one();
+            return;
+        }
+        
+        // Budget exhausted or no local waiters: give other nodes (and readers) a turn
+        node.handoffs = 0;
+        node.owns_global = false;
+        node.write_cv.notify_one();
+        lock.unlock();
+        
+        release_global();
+    }
+    
+    // Lock statistics for the final report
+    void get_stats(int& node_count, long long& global, long long& local) const {
+        node_count = nodes.size();
+        global = global_acquisitions;
+        local = local_handoffs;
+    }
+    
+    // Print how the waits were resolved
+    void print_wait_stats() const {
+        wait.print_report();
+    }
+};
+
+// Shared resource (simulated as an integer)
+class SharedResource {
+private:
+    int data = 0;
+    CohortReadersWriterLock rwlock;
+    std::mutex print_mutex;  // For synchronized console output
+    
+public:
+    // Reader function: reads data from the shared resource
+    OpTiming reader(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " wants to read." << std::endl;
+        }
+        
+        // Acquire read lock
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        rwlock.read_lock();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " is reading data: " << data 
+                      << " (waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Simulate reading process
+        std::this_thread::sleep_for(std::chrono::milliseconds(100 + (rand() % 900)));
+        
+        // Release read lock
+        rwlock.read_unlock();
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " finished reading." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Writer function: modifies the shared resource
+    OpTiming writer(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " wants to write." << std::endl;
+        }
+        
+        // Acquire write lock
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        rwlock.write_lock();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        // Simulate writing process
+        int new_value = rand() % 1000;
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " is writing data: " << new_value 
+                      << " (waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Modify the shared data
+        data = new_value;
+        
+        // Simulate additional processing
+        std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
+        
+        // Release write lock
+        rwlock.write_unlock();
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " finished writing." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Get the current data value
+    int get_data() const {
+        return data;
+    }
+    
+    // Print how often the global lock changed hands versus stayed on a node
+    void print_lock_stats() const {
+        int nodes;
+        long long global, local;
+        rwlock.get_stats(nodes, global, local);
+        std::cout << "\n----- COHORT LOCK -----" << std::endl;
+        std::cout << "Cohort nodes: " << nodes << std::endl;
+        std::cout << "Global lock acquisitions: " << global << std::endl;
+        std::cout << "Local writer handoffs: " << local << std::endl;
+        rwlock.print_wait_stats();
+    }
+};
+
+// Statistics for the demonstration
+struct Statistics {
+    std::atomic<int> total_reads{0};
+    std::atomic<int> total_writes{0};
+    std::atomic<int> readers_waiting{0};
+    std::atomic<int> writers_waiting{0};
+    std::atomic<long long> reader_wait_time{0};
+    std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("NUMA Cohort", num_readers, num_writers, operations_per_thread) {}
+};
+
+int main() {
+    // Seed for random number generation
+    srand(static_cast<unsigned int>(time(nullptr)));
+    
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<CohortReadersWriterLock>("NUMA Cohort", "CohortReadersWriterLock", "one cache-line-aligned node (mutex, three condition variables) per NUMA node");
+    }
+    
+    // WORKLOAD=map benchmarks a striped hash map built on this lock instead
+    if (map_workload_requested()) {
+        return run_map_benchmark<CohortReadersWriterLock>("NUMA Cohort");
+    }
+    
+    // Create shared resource
+    SharedResource resource;
+    
+    // Create threads for readers and writers
+    // Use environment variables if provided, otherwise use defaults
+    const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
+    const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
+    const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
+    
+    std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
+              << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
+    
+    std::vector<std::thread> threads;
+    
+    std::cout << "Starting readers-writers demonstration (NUMA COHORT) with "
+              << num_readers << " readers and " 
+              << num_writers << " writers." << std::endl;
+    
+    // Lambda to simulate reader behavior with random intervals
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to read
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.readers_waiting++;
+            OpTiming timing = resource.reader(id);
+            stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_reads++;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
+        }
+    };
+    
+    // Lambda to simulate writer behavior with random intervals
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to write
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.writers_waiting++;
+            OpTiming timing = resource.writer(id);
+            stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_writes++;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
+        }
+    };
+    
+    // Start reader threads
+    for (int i = 0; i < num_readers; i++) {
+        threads.emplace_back(reader_task, i + 1);
+    }
+    
+    // Start writer threads
+    for (int i = 0; i < num_writers; i++) {
+        threads.emplace_back(writer_task, i + 1);
+    }
+    
+    // Monitor thread for displaying statistics
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
+        int expected_operations = (num_readers + num_writers) * operations_per_thread;
+        int total_operations = 0;
+        
+        while (!run.done(total_operations, expected_operations)) {
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            total_operations = stats.total_reads + stats.total_writes;
+            
+            std::cout << "\n----- STATISTICS -----" << std::endl;
+            std::cout << "Completed reads: " << stats.total_reads << std::endl;
+            std::cout << "Completed writes: " << stats.total_writes << std::endl;
+            std::cout << "Readers waiting: " << stats.readers_waiting << std::endl;
+            std::cout << "Writers waiting: " << stats.writers_waiting << std::endl;
+            
+            // Calculate average wait times
+            float avg_reader_wait = stats.total_reads > 0 ? 
+                                     static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+            float avg_writer_wait = stats.total_writes > 0 ? 
+                                     static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+            
+            std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+            std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
+        }
+    });
+    
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
+    // Wait for all threads to complete
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    run.finish();
+    
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+    
+    std::cout << "\nDemonstration completed!" << std::endl;
+    std::cout << "Final statistics:" << std::endl;
+    std::cout << "Total reads: " << stats.total_reads << std::endl;
+    std::cout << "Total writes: " << stats.total_writes << std::endl;
+    
+    // Calculate final average wait times
+    float avg_reader_wait = stats.total_reads > 0 ? 
+                             static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+    float avg_writer_wait = stats.total_writes > 0 ? 
+                             static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+    
+    std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+    std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+    
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
+    return 0;
+}
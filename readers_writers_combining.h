@@ -0,0 +1,122 @@
+/**
+ * readers_writers_combining.h - Flat combining for writers
+ *
+ * Normally every writer takes the exclusive lock for its own update, so a burst of N
+ * writers costs N reader drains and N handoffs. With COMBINE_WRITES=1 a writer instead
+ * publishes its update in its own slot; whichever writer finds no combiner active becomes
+ * the combiner, takes the exclusive lock once, applies every pending update as one batch
+ * and wakes the writers whose updates it applied. Writers that arrive while a batch is in
+ * progress are picked up by the next combiner, which is one of them.
+ *
+ * The lock type only needs write_lock()/write_unlock().
+ */
+
+#ifndef READERS_WRITERS_COMBINING_H
+#define READERS_WRITERS_COMBINING_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "readers_writers_bench.h"
+
+template <typename Lock>
+class WriteCombiner {
+public:
+    using Update = std::pair<int, int>;  // Writer id, value
+
+private:
+    struct Slot {
+        int value = 0;
+        bool pending = false;   // Published, not yet picked up by a combiner
+        bool done = false;      // Applied; timing is final
+        OpTiming timing;
+    };
+
+    Lock& lock;
+    bool active;
+    std::mutex mtx;                     // Protects the slots and the combiner flag (never held
+                                        // while the exclusive lock is being acquired)
+    std::condition_variable done_cv;
+    std::map<int, Slot> slots;          // Writer id -> slot; map nodes never move
+    bool combining = false;
+
+    long long batches = 0;              // Exclusive acquisitions made by combiners
+    long long combined_writes = 0;
+    size_t largest_batch = 0;
+
+public:
+    explicit WriteCombiner(Lock& lock)
+        : lock(lock), active(std::getenv("COMBINE_WRITES") && std::string(std::getenv("COMBINE_WRITES")) != "0") {}
+
+    bool enabled() const {
+        return active;
+    }
+
+    // Publish `value` for writer `id` and return once it has been applied. `apply_batch`
+    // receives all updates of a batch and runs with the exclusive lock held.
+    template <typename ApplyBatch>
+    OpTiming write(int id, int value, ApplyBatch apply_batch) {
+        std::unique_lock<std::mutex> guard(mtx);
+        Slot& slot = slots[id];
+        slot.value = value;
+        slot.pending = true;
+        slot.done = false;
+        slot.timing.requested = std::chrono::steady_clock::now();
+
+        while (!slot.done) {
+            if (combining) {
+                done_cv.wait(guard);
+                continue;
+            }
+
+            // Become the combiner: collect every pending update, including our own
+            combining = true;
+            std::vector<Update> batch;
+            for (auto& entry : slots) {
+                if (entry.second.pending) {
+                    entry.second.pending = false;
+                    batch.push_back({entry.first, entry.second.value});
+                }
+            }
+            guard.unlock();
+
+            lock.write_lock();
+            auto granted = std::chrono::steady_clock::now();
+            apply_batch(batch);
+            lock.write_unlock();
+            auto released = std::chrono::steady_clock::now();
+
+            guard.lock();
+            for (const Update& update : batch) {
+                Slot& applied = slots[update.first];
+                applied.timing.granted = granted;
+                applied.timing.released = released;
+                applied.done = true;
+            }
+            batches++;
+            combined_writes += batch.size();
+            largest_batch = std::max(largest_batch, batch.size());
+            combining = false;
+            done_cv.notify_all();
+        }
+        return slot.timing;
+    }
+
+    void print_report() const {
+        if (!active) return;
+        std::cout << "\n----- WRITE COMBINING -----" << std::endl;
+        std::cout << "Exclusive acquisitions: " << batches << " for " << combined_writes << " writes" << std::endl;
+        std::cout << "Writes per acquisition (avg/max): "
+                  << (batches > 0 ? static_cast<double>(combined_writes) / batches : 0.0)
+                  << " / " << largest_batch << std::endl;
+    }
+};
+
+#endif // READERS_WRITERS_COMBINING_H
@@ -0,0 +1,304 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_compact.h"
+#include "readers_writers_map.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+
+// The demonstration guards a single value with the 4-byte CompactReadersWriterLock from
+// readers_writers_compact.h, so it can be compared with the larger locks under the same
+// workload; WORKLOAD=map and WORKLOAD=sizes show it in the setting it is meant for, one
+// lock per stripe or record.
+
+// Shared resource (simulated as an integer)
+class SharedResource {
+private:
+    int data = 0;
+    CompactReadersWriterLock rwlock;
+    std::mutex print_mutex;  // For synchronized console output
+    
+public:
+    // Reader function: reads data from the shared resource
+    OpTiming reader(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " wants to read." << std::endl;
+        }
+        
+        // Acquire read lock
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        rwlock.read_lock();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " is reading data: " << data 
+                      << " (waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Simulate reading process
+        std::this_thread::sleep_for(std::chrono::milliseconds(100 + (rand() % 900)));
+        
+        // Release read lock
+        rwlock.read_unlock();
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " finished reading." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Writer function: modifies the shared resource
+    OpTiming writer(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " wants to write." << std::endl;
+        }
+        
+        // Acquire write lock
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        rwlock.write_lock();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        // Simulate writing process
+        int new_value = rand() % 1000;
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " is writing data: " << new_value 
+                      << " (waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Modify the shared data
+        data = new_value;
+        
+        // Simulate additional processing
+        std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
+        
+        // Release write lock
+        rwlock.write_unlock();
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " finished writing." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Get the current data value
+    int get_data() const {
+        return data;
+    }
+    
+    // Print the slow-path statistics shared by all compact locks
+    void print_lock_stats() const {
+        CompactReadersWriterLock::print_report();
+    }
+};
+
+// Statistics for the demonstration
+struct Statistics {
+    std::atomic<int> total_reads{0};
+    std::atomic<int> total_writes{0};
+    std::atomic<int> readers_waiting{0};
+    std::atomic<int> writers_waiting{0};
+    std::atomic<long long> reader_wait_time{0};
+    std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("Compact 4-byte", num_readers, num_writers, operations_per_thread) {}
+};
+
+int main() {
+    // Seed for random number generation
+    srand(static_cast<unsigned int>(time(nullptr)));
+    
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<CompactReadersWriterLock>("Compact 4-byte", "CompactReadersWriterLock");
+    }
+    
+    // WORKLOAD=map benchmarks a striped hash map built on this lock instead
+    if (map_workload_requested()) {
+        return run_map_benchmark<CompactReadersWriterLock>("Compact 4-byte");
+    }
+    
+    // Create shared resource
+    SharedResource resource;
+    
+    // Create threads for readers and writers
+    // Use environment variables if provided, otherwise use defaults
+    const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
+    const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
+    const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
+    
+    std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
+              << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
+    
+    std::vector<std::thread> threads;
+    
+    std::cout << "Starting readers-writers demonstration (COMPACT 4-BYTE LOCK) with "
+              << num_readers << " readers and " 
+              << num_writers << " writers." << std::endl;
+    
+    // Lambda to simulate reader behavior with random intervals
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to read
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.readers_waiting++;
+            OpTiming timing = resource.reader(id);
+            stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_reads++;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
+        }
+    };
+    
+    // Lambda to simulate writer behavior with random intervals
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to write
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.writers_waiting++;
+            OpTiming timing = resource.writer(id);
+            stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_writes++;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
+        }
+    };
+    
+    // Start reader threads
+    for (int i = 0; i < num_readers; i++) {
+        threads.emplace_back(reader_task, i + 1);
+    }
+    
+    // Start writer threads
+    for (int i = 0; i < num_writers; i++) {
+        threads.emplace_back(writer_task, i + 1);
+    }
+    
+    // Monitor thread for displaying statistics
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
+        int expected_operations = (num_readers + num_writers) * operations_per_thread;
+        int total_operations = 0;
+        
+        while (!run.done(total_operations, expected_operations)) {
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            total_operations = stats.total_reads + stats.total_writes;
+            
+            std::cout << "\n----- STATISTICS -----" << std::endl;
+            std::cout << "Completed reads: " << stats.total_reads << std::endl;
+            std::cout << "Completed writes: " << stats.total_writes << std::endl;
+            std::cout << "Readers waiting: " << stats.readers_waiting << std::endl;
+            std::cout << "Writers waiting: " << stats.writers_waiting << std::endl;
+            
+            // Calculate average wait times
+            float avg_reader_wait = stats.total_reads > 0 ? 
+                                     static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+            float avg_writer_wait = stats.total_writes > 0 ? 
+                                     static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+            
+            std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+            std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
+        }
+    });
+    
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
+    // Wait for all threads to complete
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    run.finish();
+    
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+    
+    std::cout << "\nDemonstration completed!" << std::endl;
+    std::cout << "Final statistics:" << std::endl;
+    std::cout << "Total reads: " << stats.total_reads << std::endl;
+    std::cout << "Total writes: " << stats.total_writes << std::endl;
+    
+    // Calculate final average wait times
+    float avg_reader_wait = stats.total_reads > 0 ? 
+                             static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+    float avg_writer_wait = stats.total_writes > 0 ? 
+                             static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+    
+    std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+    std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+    
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
+    return 0;
+}
@@ -0,0 +1,170 @@
+/**
+ * readers_writers_compact.h - 4-byte reader/writer lock for per-record locking
+ *
+ * The other locks in this project carry mutexes, condition variables and counters and
+ * take from 40 to several hundred bytes; with one lock beside every record of a large
+ * array they outweigh the records. CompactReadersWriterLock keeps its whole state in one
+ * 32-bit word:
+ *
+ *   bits  0-15  active readers (at most 65535)
+ *   bits 16-29  writers waiting to acquire (at most 16383)
+ *   bit   30    at least one reader is parked
+ *   bit   31    a writer holds the lock
+ *
+ * An uncontended acquire is one compare-and-swap on that word and a release one atomic
+ * subtraction or AND. As in the writers-priority lock, new readers stay out while a
+ * writer holds or waits for the lock. A thread whose first attempt fails goes through the
+ * shared WaitStrategy and then parks on the word itself with a Linux futex: the kernel
+ * keeps the sleepers in its own table hashed by address, so the lock needs no queue or
+ * condition variable. Releases only make the wake system call when the old word shows a
+ * waiter. On platforms without futexes the lock parks in the global parking lot
+ * (readers_writers_parking.h) instead, keyed by the same address.
+ *
+ * Statistics are shared by all compact locks and only updated on the slow path, so the
+ * fast path never writes anything but the lock word.
+ */
+
+#ifndef READERS_WRITERS_COMPACT_H
+#define READERS_WRITERS_COMPACT_H
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "readers_writers_parking.h"
+#include "readers_writers_wait.h"
+
+class CompactReadersWriterLock {
+private:
+    static constexpr uint32_t READER_MASK = 0xFFFF;
+    static constexpr uint32_t WAITING_WRITER = 1u << 16;
+    static constexpr uint32_t WAITING_WRITER_MASK = 0x3FFFu << 16;
+    static constexpr uint32_t READERS_PARKED = 1u << 30;
+    static constexpr uint32_t WRITER = 1u << 31;
+
+    std::atomic<uint32_t> state{0};
+
+    // Shared by every compact lock in the process
+    struct SlowPath {
+        WaitStrategy wait;
+        std::atomic<long long> reads{0};      // Read acquisitions that missed the fast path
+        std::atomic<long long> writes{0};     // Write acquisitions that missed the fast path
+        std::atomic<long long> parks{0};      // Futex (or parking lot) waits
+        std::atomic<long long> wakes{0};      // Wake calls
+    };
+
+    static SlowPath& slow_path() {
+        static SlowPath shared;
+        return shared;
+    }
+
+    // Sleep until woken, unless the word no longer equals `expected`
+    void park(uint32_t expected) {
+        slow_path().parks.fetch_add(1, std::memory_order_relaxed);
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+        ParkingLot::global().park(&state, 0, [this, expected] { return state.load(std::memory_order_relaxed) == expected; });
+#endif
+    }
+
+    // Readers and writers sleep on the same word, so a release wakes all of them and the
+    // ones that still cannot enter park again
+    void wake_all() {
+        slow_path().wakes.fetch_add(1, std::memory_order_relaxed);
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+        ParkingLot::global().unpark_all(&state);
+#endif
+    }
+
+    static bool readers_admitted(uint32_t word) {
+        return (word & (WRITER | WAITING_WRITER_MASK)) == 0 && (word & READER_MASK) != READER_MASK;
+    }
+
+    static bool writer_admitted(uint32_t word) {
+        return (word & (WRITER | READER_MASK)) == 0;
+    }
+
+public:
+    bool try_read_lock() {
+        uint32_t word = state.load(std::memory_order_relaxed);
+        return readers_admitted(word) &&
+               state.compare_exchange_strong(word, word + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    bool try_write_lock() {
+        uint32_t word = state.load(std::memory_order_relaxed);
+        return writer_admitted(word) &&
+               state.compare_exchange_strong(word, word | WRITER, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void read_lock() {
+        if (try_read_lock()) return;
+        slow_path().reads.fetch_add(1, std::memory_order_relaxed);
+        slow_path().wait.acquire([this] { return try_read_lock(); }, [this] {
+            for (;;) {
+                uint32_t word = state.load(std::memory_order_relaxed);
+                if (readers_admitted(word)) {
+                    if (state.compare_exchange_weak(word, word + 1, std::memory_order_acquire, std::memory_order_relaxed)) return;
+                } else if ((word & READER_MASK) == READER_MASK && (word & (WRITER | WAITING_WRITER_MASK)) == 0) {
+                    std::this_thread::yield();    // Reader count saturated; nobody will wake us
+                } else if ((word & READERS_PARKED) ||
+                           state.compare_exchange_weak(word, word | READERS_PARKED, std::memory_order_relaxed)) {
+                    // The flag makes the writer's release wake us
+                    park(word | READERS_PARKED);
+                }
+            }
+        });
+    }
+
+    void read_unlock() {
+        uint32_t previous = state.fetch_sub(1, std::memory_order_release);
+        // The last reader out lets a waiting writer in
+        if ((previous & READER_MASK) == 1 && (previous & WAITING_WRITER_MASK) != 0) wake_all();
+    }
+
+    void write_lock() {
+        if (try_write_lock()) return;
+        slow_path().writes.fetch_add(1, std::memory_order_relaxed);
+        slow_path().wait.acquire([this] { return try_write_lock(); }, [this] {
+            // Counting ourselves as waiting keeps new readers out until we are in
+            state.fetch_add(WAITING_WRITER, std::memory_order_relaxed);
+            for (;;) {
+                uint32_t word = state.load(std::memory_order_relaxed);
+                if (writer_admitted(word)) {
+                    if (state.compare_exchange_weak(word, (word - WAITING_WRITER) | WRITER,
+                                                    std::memory_order_acquire, std::memory_order_relaxed)) return;
+                } else {
+                    park(word);
+                }
+            }
+        });
+    }
+
+    void write_unlock() {
+        uint32_t previous = state.fetch_and(~(WRITER | READERS_PARKED), std::memory_order_release);
+        if ((previous & (READERS_PARKED | WAITING_WRITER_MASK)) != 0) wake_all();
+    }
+
+    static void print_report() {
+        SlowPath& shared = slow_path();
+        std::cout << "\n----- COMPACT LOCK -----" << std::endl;
+        std::cout << "Lock size: " << sizeof(CompactReadersWriterLock) << " bytes (alignment "
+                  << alignof(CompactReadersWriterLock) << ")" << std::endl;
+        std::cout << "Slow-path acquisitions (reads/writes): " << shared.reads << " / " << shared.writes << std::endl;
+        std::cout << "Futex waits: " << shared.parks << ", wake calls: " << shared.wakes << std::endl;
+        shared.wait.print_report();
+    }
+};
+
+static_assert(sizeof(CompactReadersWriterLock) == 4, "the compact lock must stay one 32-bit word");
+
+#endif // READERS_WRITERS_COMPACT_H
@@ -0,0 +1,381 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
+
+// Immutable version of the shared data. Besides the demo value it carries a table of
+// COW_TABLE_SIZE entries (default 1024), standing in for a configuration or routing table,
+// so every write pays for a realistic copy.
+struct Snapshot {
+    long long version = 0;
+    int data = 0;
+    std::vector<int> table;
+};
+
+// Copy-on-write Readers-Writers cell
+// Readers load the current version through an atomic shared_ptr and keep it alive for as
+// long as they read it; they never wait for a writer. A writer takes the writer mutex,
+// copies the current version, modifies the copy and publishes it with one atomic store.
+// Readers that started earlier keep their old version, which is freed when the last of
+// them drops it. Only writers wait for each other.
+class CopyOnWriteCell {
+private:
+    std::mutex write_mtx;                       // Serialises writers; readers never take it
+    WaitStrategy wait;
+    
+    // Declared before `current` so the deleter can still count the final release
+    std::atomic<long long> reads{0};
+    std::atomic<long long> published{0};
+    std::atomic<int> live_versions{0};
+    std::atomic<int> peak_live_versions{0};
+    double total_copy_us = 0;                   // Guarded by write_mtx
+    
+    std::shared_ptr<const Snapshot> current;    // Accessed only through std::atomic_load/store
+    
+    // Wrap a new version so the number of versions still referenced can be reported
+    std::shared_ptr<const Snapshot> make_version(Snapshot* version) {
+        int live = ++live_versions;
+        int peak = peak_live_versions.load();
+        while (live > peak && !peak_live_versions.compare_exchange_weak(peak, live)) {}
+        return std::shared_ptr<const Snapshot>(version, [this](const Snapshot* old) {
+            live_versions--;
+            delete old;
+        });
+    }
+    
+public:
+    CopyOnWriteCell() {
+        int table_size = std::getenv("COW_TABLE_SIZE") ? std::stoi(std::getenv("COW_TABLE_SIZE")) : 1024;
+        Snapshot* initial = new Snapshot;
+        initial->table.assign(std::max(table_size, 1), 0);
+        current = make_version(initial);
+    }
+    
+    // Current version. Writers hold no lock that readers take, so this never waits for a
+    // write in progress; at most it waits for another thread's pointer copy.
+    std::shared_ptr<const Snapshot> read() {
+        reads.fetch_add(1, std::memory_order_relaxed);
+        return std::atomic_load_explicit(&current, std::memory_order_acquire);
+    }
+    
+    // Acquire write ownership and return a private copy of the current version
+    std::unique_ptr<Snapshot> begin_write() {
+        wait.acquire([this] { return write_mtx.try_lock(); }, [this] { write_mtx.lock(); });
+        
+        auto copy_start = std::chrono::steady_clock::now();
+        std::unique_ptr<Snapshot> next(new Snapshot(*std::atomic_load_explicit(&current, std::memory_order_relaxed)));
+        total_copy_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - copy_start).count();
+        next->version++;
+        return next;
+    }
+    
+    // Make the new version visible to readers and release write ownership
+    void publish(std::unique_ptr<Snapshot> next) {
+        std::atomic_store_explicit(&current, make_version(next.release()), std::memory_order_release);
+        published++;
+        write_mtx.unlock();
+    }
+    
+    void print_wait_stats() const {
+        std::cout << "\n----- COPY-ON-WRITE -----" << std::endl;
+        std::cout << "Snapshot reads (never wait for a writer): " << reads << std::endl;
+        std::cout << "Versions published: " << published << std::endl;
+        std::cout << "Avg copy time per write: " << (published > 0 ? total_copy_us / published : 0.0) << " us" << std::endl;
+        std::cout << "Versions alive (now/peak): " << live_versions << " / " << peak_live_versions << std::endl;
+        std::cout << "Lock-free shared_ptr atomics: "
+                  << (std::atomic_is_lock_free(&current) ? "yes" : "no (the library guards the pointer copy with a small internal mutex)") << std::endl;
+        wait.print_report();
+    }
+};
+
+// Shared resource (an immutable snapshot replaced on every write)
+class SharedResource {
+private:
+    CopyOnWriteCell cell;
+    std::mutex print_mutex;  // For synchronized console output
+    
+public:
+    // Reader function: reads data from the current snapshot
+    OpTiming reader(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " wants to read." << std::endl;
+        }
+        
+        // Take a snapshot; this never waits for a writer
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        std::shared_ptr<const Snapshot> snapshot = cell.read();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " is reading data: " << snapshot->data
+                      << " (version " << snapshot->version << ", waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Simulate reading process; the snapshot stays valid even if writers publish meanwhile
+        std::this_thread::sleep_for(std::chrono::milliseconds(100 + (rand() % 900)));
+        
+        // Drop the snapshot
+        snapshot.reset();
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " finished reading." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Writer function: builds and publishes a new version
+    OpTiming writer(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " wants to write." << std::endl;
+        }
+        
+        // Acquire write ownership (other writers only) and copy the current version
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        std::unique_ptr<Snapshot> next = cell.begin_write();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        // Simulate writing process
+        int new_value = rand() % 1000;
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " is writing data: " << new_value
+                      << " (version " << next->version << ", waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Modify the private copy
+        next->data = new_value;
+        next->table[next->version % next->table.size()] = new_value;
+        
+        // Simulate additional processing
+        std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
+        
+        // Publish the new version
+        cell.publish(std::move(next));
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " finished writing." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Get the current data value
+    int get_data() {
+        return cell.read()->data;
+    }
+    
+    // Print lock-internal statistics
+    void print_lock_stats() const {
+        cell.print_wait_stats();
+    }
+};
+
+// Statistics for the demonstration
+struct Statistics {
+    std::atomic<int> total_reads{0};
+    std::atomic<int> total_writes{0};
+    std::atomic<int> readers_waiting{0};
+    std::atomic<int> writers_waiting{0};
+    std::atomic<long long> reader_wait_time{0};
+    std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("Copy-on-Write", num_readers, num_writers, operations_per_thread) {}
+};
+
+int main() {
+    // Seed for random number generation
+    srand(static_cast<unsigned int>(time(nullptr)));
+    
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<CopyOnWriteCell>("Copy-on-Write", "CopyOnWriteCell", "the current snapshot and every version readers still hold");
+    }
+    
+    // Create shared resource
+    SharedResource resource;
+    
+    // Create threads for readers and writers
+    // Use environment variables if provided, otherwise use defaults
+    const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
+    const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
+    const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
+    
+    std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
+              << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
+    
+    std::vector<std::thread> threads;
+    
+    std::cout << "Starting readers-writers demonstration (COPY-ON-WRITE) with "
+              << num_readers << " readers and " 
+              << num_writers << " writers." << std::endl;
+    
+    // Lambda to simulate reader behavior with random intervals
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to read
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.readers_waiting++;
+            OpTiming timing = resource.reader(id);
+            stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_reads++;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
+        }
+    };
+    
+    // Lambda to simulate writer behavior with random intervals
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to write
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.writers_waiting++;
+            OpTiming timing = resource.writer(id);
+            stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_writes++;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
+        }
+    };
+    
+    // Start reader threads
+    for (int i = 0; i < num_readers; i++) {
+        threads.emplace_back(reader_task, i + 1);
+    }
+    
+    // Start writer threads
+    for (int i = 0; i < num_writers; i++) {
+        threads.emplace_back(writer_task, i + 1);
+    }
+    
+    // Monitor thread for displaying statistics
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
+        int expected_operations = (num_readers + num_writers) * operations_per_thread;
+        int total_operations = 0;
+        
+        while (!run.done(total_operations, expected_operations)) {
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            total_operations = stats.total_reads + stats.total_writes;
+            
+            std::cout << "\n----- STATISTICS -----" << std::endl;
+            std::cout << "Completed reads: " << stats.total_reads << std::endl;
+            std::cout << "Completed writes: " << stats.total_writes << std::endl;
+            std::cout << "Readers waiting: " << stats.readers_waiting << std::endl;
+            std::cout << "Writers waiting: " << stats.writers_waiting << std::endl;
+            
+            // Calculate average wait times
+            float avg_reader_wait = stats.total_reads > 0 ? 
+                                     static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+            float avg_writer_wait = stats.total_writes > 0 ? 
+                                     static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+            
+            std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+            std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
+        }
+    });
+    
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
+    // Wait for all threads to complete
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    run.finish();
+    
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+    
+    std::cout << "\nDemonstration completed!" << std::endl;
+    std::cout << "Final statistics:" << std::endl;
+    std::cout << "Total reads: " << stats.total_reads << std::endl;
+    std::cout << "Total writes: " << stats.total_writes << std::endl;
+    
+    // Calculate final average wait times
+    float avg_reader_wait = stats.total_reads > 0 ? 
+                             static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+    float avg_writer_wait = stats.total_writes > 0 ? 
+                             static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+    
+    std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+    std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+    
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
+    return 0;
+}
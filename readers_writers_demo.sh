@@ -25,6 +25,9 @@ OPERATIONS=${OPERATIONS:-5}   # Default operations per thread
 BENCHMARK=false
 QUICK=false
 VERBOSE=false
+TRACE=false
+MAP=false
+SIZES=false
 
 print_help() {
     echo -e "${BOLD}Readers-Writers Problem Demonstration${RESET}"
@@ -35,6 +38,9 @@ print_help() {
     echo "  --benchmark    Run in benchmark mode (collect performance metrics)"
     echo "  --quick        Run a shortened version of the demo"
     echo "  --verbose      Show more detailed output"
+    echo "  --trace        Record lock events and write results/trace_<impl>.json for Perfetto"
+    echo "  --map          Benchmark a striped hash map on every lock and stripe count"
+    echo "  --sizes        Report sizeof and alignment of every lock variant"
     echo "  --help         Show this help message"
     echo ""
     echo "Environment variables:"
@@ -42,6 +48,20 @@ print_help() {
     echo "  WRITERS=n      Set number of writer threads (default: 4)"
     echo "  OPERATIONS=n   Set operations per thread (default: 5)"
     echo "  TIME_LIMIT=n   Set time limit in seconds (default: 15)"
+    echo "  DURATION=s     Run each program for a fixed measurement window instead of"
+    echo "                 OPERATIONS per thread; only operations inside the window count"
+    echo "  WARMUP=s       Warm-up before the measurement window (default: 1, needs DURATION)"
+    echo "  PLACEMENT=p    Pin threads: none, compact, scatter, physical or list (default: none)"
+    echo "  CPUS=list      CPU list for PLACEMENT=list, e.g. 0,2,4-7"
+    echo "  WAIT_STRATEGY=s  How blocked threads wait: adaptive, spin or park (default: adaptive)"
+    echo "  BYPASS_LIMIT=n   Readers allowed past a waiting writer in the extra bounded"
+    echo "                   readers-priority run (default: 2)"
+    echo "  COMBINE_WRITES=1 Batch concurrent writers under one exclusive acquisition"
+    echo "  ASYNC_WRITES=1   Queue writes for a single applier thread instead of blocking"
+    echo "                   (both: writers-priority and fair implementations)"
+    echo "                 (READER_CPUS / WRITER_CPUS set the two sides separately)"
+    echo "  MAP_STRIPE_COUNTS=\"1 4 16 64\"  Stripe counts swept by --map (see readers_writers_map.h"
+    echo "                 for MAP_THREADS, MAP_OPS, MAP_KEYS and MAP_READ_PERCENT)"
     echo ""
     echo "Examples:"
     echo "  ./readers_writers_demo.sh"
@@ -66,6 +86,18 @@ do
         VERBOSE=true
         shift
         ;;
+        --trace)
+        TRACE=true
+        shift
+        ;;
+        --map)
+        MAP=true
+        shift
+        ;;
+        --sizes)
+        SIZES=true
+        shift
+        ;;
         --help)
         print_help
         exit 0
@@ -90,13 +122,25 @@ echo "  - Readers: $READERS"
 echo "  - Writers: $WRITERS"
 echo "  - Operations per thread: $OPERATIONS"
 echo "  - Time limit: $TIME_LIMIT seconds"
-if [ "$BENCHMARK" = true ]; then
+echo "  - Thread placement: ${PLACEMENT:-none}"
+echo "  - Wait strategy: ${WAIT_STRATEGY:-adaptive}"
+if [ -n "$DURATION" ]; then
+    echo "  - Measurement window: $DURATION seconds after ${WARMUP:-1} seconds of warm-up"
+fi
+if [ "$SIZES" = true ]; then
+    echo "  - Mode: Lock footprint report"
+elif [ "$MAP" = true ]; then
+    echo "  - Mode: Hash map benchmark (stripes: ${MAP_STRIPE_COUNTS:-1 4 16 64})"
+elif [ "$BENCHMARK" = true ]; then
     echo "  - Mode: Benchmark"
 elif [ "$QUICK" = true ]; then
     echo "  - Mode: Quick demo"
 else
     echo "  - Mode: Full demonstration"
 fi
+if [ "$TRACE" = true ]; then
+    echo "  - Tracing: enabled (results/trace_<impl>.json)"
+fi
 echo ""
 
 # Compile all implementations
@@ -112,9 +156,75 @@ echo -e "${GREEN}Compilation successful!${RESET}"
 echo ""
 
 # Arrays of implementation info
-IMPLEMENTATIONS=("readers_writers" "readers_writers_semaphore" "readers_writers_readers_priority" "readers_writers_fair" "readers_writers_shared_mutex" "readers_writers_monitor" "readers_writers_educational")
-DESCRIPTIONS=("Writers-Priority" "Semaphore-based" "Readers-Priority" "Fair/Queue-based" "std::shared_mutex" "Monitor-based" "Educational")
-COLORS=("$BLUE" "$GREEN" "$YELLOW" "$MAGENTA" "$CYAN" "$RED" "$GRAY")
+IMPLEMENTATIONS=("readers_writers" "readers_writers_semaphore" "readers_writers_readers_priority" "readers_writers_fair" "readers_writers_shared_mutex" "readers_writers_monitor" "readers_writers_educational" "readers_writers_cohort" "readers_writers_adaptive" "readers_writers_cow" "readers_writers_rcu" "readers_writers_left_right" "readers_writers_mvcc" "readers_writers_lock_manager" "readers_writers_compact" "readers_writers_parking" "readers_writers_range" "readers_writers_hierarchy")
+DESCRIPTIONS=("Writers-Priority" "Semaphore-based" "Readers-Priority" "Fair/Queue-based" "std::shared_mutex" "Monitor-based" "Educational" "NUMA Cohort" "Adaptive" "Copy-on-Write" "RCU/Epoch" "Left-Right" "MVCC" "Lock Manager" "Compact 4-byte" "Parking Lot" "Range Lock" "Hierarchical")
+COLORS=("$BLUE" "$GREEN" "$YELLOW" "$MAGENTA" "$CYAN" "$RED" "$GRAY" "$BLUE" "$GREEN" "$YELLOW" "$MAGENTA" "$CYAN" "$RED" "$GRAY" "$BLUE" "$GREEN" "$YELLOW" "$MAGENTA")
+
+# Footprint mode: sizeof and alignment of the lock (or cell) of every implementation, and
+# what one lock per record would cost for an array of ten million records
+if [ "$SIZES" = true ]; then
+    mkdir -p results
+    SIZES_RESULTS_FILE="results/lock_sizes_$(date +%Y%m%d_%H%M%S).csv"
+    echo "Implementation,Lock Type,Size (bytes),Alignment (bytes),10M Locks (MB),Additional Memory" > "$SIZES_RESULTS_FILE"
+    
+    echo -e "${YELLOW}Step 2: Collecting lock footprints...${RESET}"
+    printf "${BOLD}%-18s | %-27s | %6s | %5s | %10s${RESET}\n" "Implementation" "Lock type" "Bytes" "Align" "10M locks"
+    echo "-------------------+-----------------------------+--------+-------+-----------"
+    for i in "${!IMPLEMENTATIONS[@]}"; do
+        impl=${IMPLEMENTATIONS[$i]}
+        SIZE_OUTPUT=$(WORKLOAD=sizes timeout ${TIME_LIMIT}s ./$impl 2>&1 || true)
+        SIZE_LINE=$(echo "$SIZE_OUTPUT" | grep "^Lock size:")
+        BYTES=$(echo "$SIZE_LINE" | grep -o -E '[0-9]+ bytes' | head -1 | grep -o -E '[0-9]+' || echo "N/A")
+        ALIGN=$(echo "$SIZE_LINE" | grep -o -E 'alignment [0-9]+' | grep -o -E '[0-9]+' || echo "N/A")
+        TYPE=$(echo "$SIZE_LINE" | sed -E 's/.*\((.*)\)$/\1/')
+        EXTRA=$(echo "$SIZE_OUTPUT" | grep "^Additional memory:" | sed 's/^Additional memory: //')
+        if [ "$BYTES" != "N/A" ]; then
+            # A lock array is padded to the alignment, so round each lock up to it
+            STRIDE=$(( (BYTES + ALIGN - 1) / ALIGN * ALIGN ))
+            ARRAY_MB=$(awk -v s="$STRIDE" 'BEGIN { printf "%.1f", s * 10000000 / 1048576 }')
+        else
+            ARRAY_MB="N/A"
+        fi
+        echo "${DESCRIPTIONS[$i]},$TYPE,$BYTES,$ALIGN,$ARRAY_MB,\"$EXTRA\"" >> "$SIZES_RESULTS_FILE"
+        printf "${COLORS[$i]}%-18s${RESET} | %-27s | %6s | %5s | %7s MB\n" "${DESCRIPTIONS[$i]}" "$TYPE" "$BYTES" "$ALIGN" "$ARRAY_MB"
+    done
+    echo ""
+    echo -e "${GREEN}Full results saved to: ${RESET}$SIZES_RESULTS_FILE"
+    exit 0
+fi
+
+# Hash map mode: get/put throughput of readers_writers_map.h for every lock policy and
+# stripe count. Only the lock-based implementations can back the map.
+if [ "$MAP" = true ]; then
+    mkdir -p results
+    MAP_RESULTS_FILE="results/map_benchmark_$(date +%Y%m%d_%H%M%S).csv"
+    echo "Implementation,Stripes,Threads,Ops/s,Gets/s,Puts/s" > "$MAP_RESULTS_FILE"
+    
+    echo -e "${YELLOW}Step 2: Running hash map benchmark...${RESET}"
+    printf "${BOLD}%-18s | %7s | %12s | %12s | %12s${RESET}\n" "Implementation" "Stripes" "Ops/s" "Gets/s" "Puts/s"
+    echo "-------------------+---------+--------------+--------------+-------------"
+    for i in "${!IMPLEMENTATIONS[@]}"; do
+        impl=${IMPLEMENTATIONS[$i]}
+        # The snapshot, RCU, Left-Right and MVCC backends, the lock manager and the range lock
+        # have no plain reader/writer lock to stripe
+        case $impl in
+            readers_writers_cow|readers_writers_rcu|readers_writers_left_right|readers_writers_mvcc|readers_writers_lock_manager|readers_writers_range) continue ;;
+        esac
+        for stripes in ${MAP_STRIPE_COUNTS:-1 4 16 64}; do
+            MAP_OUTPUT=$(WORKLOAD=map MAP_STRIPES=$stripes timeout ${TIME_LIMIT}s ./$impl 2>&1 || true)
+            THREADS=$(echo "$MAP_OUTPUT" | grep "^Stripes:" | grep -o -E 'threads: [0-9]+' | grep -o -E '[0-9]+' || echo "N/A")
+            RATES=($(echo "$MAP_OUTPUT" | grep "^Map throughput:" | grep -o -E '[0-9]+(\.[0-9]+)?(e\+?[0-9]+)?' || true))
+            OPS=${RATES[0]:-N/A}
+            GETS=${RATES[1]:-N/A}
+            PUTS=${RATES[2]:-N/A}
+            echo "${DESCRIPTIONS[$i]},$stripes,$THREADS,$OPS,$GETS,$PUTS" >> "$MAP_RESULTS_FILE"
+            printf "${COLORS[$i]}%-18s${RESET} | %7s | %12s | %12s | %12s\n" "${DESCRIPTIONS[$i]}" "$stripes" "$OPS" "$GETS" "$PUTS"
+        done
+    done
+    echo ""
+    echo -e "${GREEN}Full results saved to: ${RESET}$MAP_RESULTS_FILE"
+    exit 0
+fi
 
 # Set up for benchmark mode
 if [ "$BENCHMARK" = true ]; then
@@ -123,16 +233,17 @@ if [ "$BENCHMARK" = true ]; then
     
     # Create a CSV file for results
     RESULTS_FILE="results/benchmark_$(date +%Y%m%d_%H%M%S).csv"
-    echo "Implementation,Readers,Writers,Operations,Total Reads,Total Writes,Reader Wait Time (ms),Writer Wait Time (ms)" > "$RESULTS_FILE"
+    echo "Implementation,Readers,Writers,Operations,Total Reads,Total Writes,Reader Wait Time (ms),Writer Wait Time (ms),Max Reader Wait (ms),Max Writer Wait (ms),Jain Reader Wait,Jain Writer Wait,Writers Overtaken,Readers Overtaken,Throughput (ops/s),Placement,Topology" > "$RESULTS_FILE"
     echo -e "${YELLOW}Results will be saved to: ${RESET}$RESULTS_FILE"
     echo ""
 fi
 
-# Function to run a single implementation
+# Function to run a single implementation (the optional second argument overrides its
+# description, for runs of the same program with different settings)
 run_implementation() {
     local index=$1
     local impl=${IMPLEMENTATIONS[$index]}
-    local desc=${DESCRIPTIONS[$index]}
+    local desc=${2:-${DESCRIPTIONS[$index]}}
     local color=${COLORS[$index]}
     
     if [ "$QUICK" = true ] && [ "$impl" = "readers_writers_educational" ]; then
@@ -145,15 +256,32 @@ run_implementation() {
     echo -e "${BOLD}${color}======================================================${RESET}"
     
     local exit_code=0
+    local trace_file=""
+    
+    if [ "$TRACE" = true ]; then
+        mkdir -p results
+        trace_file="results/trace_${impl}.bin"
+        rm -f "$trace_file"
+    fi
     
     if [ "$VERBOSE" = true ]; then
-        READERS=$READERS WRITERS=$WRITERS OPERATIONS=$OPERATIONS timeout ${TIME_LIMIT}s ./$impl | grep -E "Total|Avg|Progress|\-\-\-" || true
+        TRACE_FILE=$trace_file READERS=$READERS WRITERS=$WRITERS OPERATIONS=$OPERATIONS timeout ${TIME_LIMIT}s ./$impl | grep -E "Total|Avg|Progress|\-\-\-" || true
         exit_code=${PIPESTATUS[0]}
     else
-        READERS=$READERS WRITERS=$WRITERS OPERATIONS=$OPERATIONS timeout ${TIME_LIMIT}s ./$impl || true
+        TRACE_FILE=$trace_file READERS=$READERS WRITERS=$WRITERS OPERATIONS=$OPERATIONS timeout ${TIME_LIMIT}s ./$impl || true
         exit_code=$?
     fi
     
+    # Convert the binary trace (only written if the run finished within the time limit)
+    if [ -n "$trace_file" ]; then
+        if [ -f "$trace_file" ]; then
+            ./readers_writers_trace_convert "$trace_file" "${trace_file%.bin}.json"
+            echo -e "${GREEN}Trace saved to ${trace_file%.bin}.json (open in https://ui.perfetto.dev)${RESET}"
+        else
+            echo -e "${YELLOW}No trace recorded: the run did not finish within ${TIME_LIMIT}s${RESET}"
+        fi
+    fi
+    
     # Display a message when timeout occurs
     if [ $exit_code -eq 124 ]; then
         echo -e "${YELLOW}Time limit reached (${TIME_LIMIT}s). Moving to next implementation...${RESET}"
@@ -175,13 +303,34 @@ run_implementation() {
         READER_WAIT=$(echo "$STATS_OUTPUT" | grep -E "reader wait|Reader wait" | tail -1 | grep -o -E '[0-9]+(\.[0-9]+)?' | head -1 || echo "N/A")
         WRITER_WAIT=$(echo "$STATS_OUTPUT" | grep -E "writer wait|Writer wait" | tail -1 | grep -o -E '[0-9]+(\.[0-9]+)?' | head -1 || echo "N/A")
         
+        # Fairness and starvation metrics (see the FAIRNESS section of each program's output)
+        MAX_READER_WAIT=$(echo "$STATS_OUTPUT" | grep "Longest wait for a reader" | grep -o -E '[0-9]+(\.[0-9]+)?' | head -1 || echo "N/A")
+        MAX_WRITER_WAIT=$(echo "$STATS_OUTPUT" | grep "Longest wait for a writer" | grep -o -E '[0-9]+(\.[0-9]+)?' | head -1 || echo "N/A")
+        JAIN_READER_WAIT=$(echo "$STATS_OUTPUT" | grep "Jain's index (reader mean wait)" | grep -o -E '[0-9]+(\.[0-9]+)?(e-?[0-9]+)?$' || echo "N/A")
+        JAIN_WRITER_WAIT=$(echo "$STATS_OUTPUT" | grep "Jain's index (writer mean wait)" | grep -o -E '[0-9]+(\.[0-9]+)?(e-?[0-9]+)?$' || echo "N/A")
+        WRITERS_OVERTAKEN=$(echo "$STATS_OUTPUT" | grep "Writers overtaken" | grep -o -E '[0-9]+' | head -1 || echo "N/A")
+        READERS_OVERTAKEN=$(echo "$STATS_OUTPUT" | grep "Readers overtaken" | grep -o -E '[0-9]+' | head -1 || echo "N/A")
+        THROUGHPUT=$(echo "$STATS_OUTPUT" | grep "^Throughput" | grep -o -E '[0-9]+(\.[0-9]+)?' | head -1 || echo "N/A")
+        
+        # Record where the threads ran so results from different machines stay comparable
+        PLACEMENT_USED=$(echo "$STATS_OUTPUT" | grep "^Placement:" | head -1 | sed -e 's/^Placement: //' -e 's/,/ /g' || echo "N/A")
+        PIN_FAILURES=$(echo "$STATS_OUTPUT" | grep "^Pin failures:" | grep -o -E '[0-9]+' | head -1 || true)
+        if [ -n "$PIN_FAILURES" ] && [ "$PIN_FAILURES" -gt 0 ]; then
+            PLACEMENT_USED="$PLACEMENT_USED ($PIN_FAILURES pins failed)"
+        fi
+        TOPOLOGY=$(echo "$STATS_OUTPUT" | grep "^Topology:" | head -1 | sed -e 's/^Topology: //' -e 's/,/;/g' || echo "N/A")
+        
         # Add to results file
-        echo "$desc,$READERS,$WRITERS,$OPERATIONS,$TOTAL_READS,$TOTAL_WRITES,$READER_WAIT,$WRITER_WAIT" >> "$RESULTS_FILE"
+        echo "$desc,$READERS,$WRITERS,$OPERATIONS,$TOTAL_READS,$TOTAL_WRITES,$READER_WAIT,$WRITER_WAIT,$MAX_READER_WAIT,$MAX_WRITER_WAIT,$JAIN_READER_WAIT,$JAIN_WRITER_WAIT,$WRITERS_OVERTAKEN,$READERS_OVERTAKEN,$THROUGHPUT,$PLACEMENT_USED,$TOPOLOGY" >> "$RESULTS_FILE"
         
         # Print summary
         echo -e "${BOLD}${color}Summary for ${desc}:${RESET}"
         echo -e "  Total reads: ${BOLD}$TOTAL_READS${RESET}, Total writes: ${BOLD}$TOTAL_WRITES${RESET}"
         echo -e "  Avg reader wait: ${BOLD}$READER_WAIT ms${RESET}, Avg writer wait: ${BOLD}$WRITER_WAIT ms${RESET}"
+        echo -e "  Max reader wait: ${BOLD}$MAX_READER_WAIT ms${RESET}, Max writer wait: ${BOLD}$MAX_WRITER_WAIT ms${RESET}"
+        echo -e "  Jain's index (mean wait): readers ${BOLD}$JAIN_READER_WAIT${RESET}, writers ${BOLD}$JAIN_WRITER_WAIT${RESET}"
+        echo -e "  Writers overtaken by readers: ${BOLD}$WRITERS_OVERTAKEN${RESET}, Readers overtaken by writers: ${BOLD}$READERS_OVERTAKEN${RESET}"
+        echo -e "  Throughput: ${BOLD}$THROUGHPUT ops/s${RESET}"
         echo ""
     fi
     
@@ -193,6 +342,14 @@ echo -e "${YELLOW}Step 2: Running demonstration...${RESET}"
 
 for i in "${!IMPLEMENTATIONS[@]}"; do
     run_implementation $i
+    # The readers-priority lock only bounds writer starvation with BYPASS_LIMIT set, so run
+    # that path as well
+    if [ "${IMPLEMENTATIONS[$i]}" = "readers_writers_readers_priority" ]; then
+        (
+            export BYPASS_LIMIT=${BYPASS_LIMIT:-2}
+            run_implementation $i "${DESCRIPTIONS[$i]} (BYPASS_LIMIT=$BYPASS_LIMIT)"
+        )
+    fi
 done
 
 # If benchmark mode, generate a simple report
@@ -201,11 +358,11 @@ if [ "$BENCHMARK" = true ]; then
     echo -e "${BOLD}Benchmark Results Summary:${RESET}"
     
     # Display the benchmark results in a table
-    echo -e "${BOLD}Implementation   | Reads | Writes | Reader Wait | Writer Wait${RESET}"
-    echo "----------------+-------+--------+-------------+-----------"
+    echo -e "${BOLD}Implementation   | Reads | Writes | Reader Wait | Writer Wait | Max R Wait | Max W Wait | W Overtaken | R Overtaken | Ops/s${RESET}"
+    echo "----------------+-------+--------+-------------+-------------+------------+------------+-------------+-------------+--------"
     
     if [ -f "$RESULTS_FILE" ]; then
-        while IFS=, read -r impl readers writers ops reads writes reader_wait writer_wait; do
+        while IFS=, read -r impl readers writers ops reads writes reader_wait writer_wait max_reader_wait max_writer_wait jain_reader jain_writer writers_overtaken readers_overtaken throughput placement topology; do
             # Skip header row
             if [ "$impl" != "Implementation" ]; then
                 # Replace empty or N/A values with dashes
@@ -213,6 +370,11 @@ if [ "$BENCHMARK" = true ]; then
                 writes=${writes:-"-"}
                 reader_wait=${reader_wait:-"-"}
                 writer_wait=${writer_wait:-"-"}
+                max_reader_wait=${max_reader_wait:-"-"}
+                max_writer_wait=${max_writer_wait:-"-"}
+                writers_overtaken=${writers_overtaken:-"-"}
+                readers_overtaken=${readers_overtaken:-"-"}
+                throughput=${throughput:-"-"}
                 
                 # Format wait times with ms suffix if numeric
                 if [[ "$reader_wait" =~ ^[0-9]+(\.[0-9]+)?$ ]]; then
@@ -222,7 +384,8 @@ if [ "$BENCHMARK" = true ]; then
                     writer_wait="${writer_wait}ms"
                 fi
                 
-                printf "%-15s | %5s | %6s | %11s | %10s\n" "$impl" "$reads" "$writes" "$reader_wait" "$writer_wait"
+                printf "%-15s | %5s | %6s | %11s | %11s | %10s | %10s | %11s | %11s | %6s\n" "$impl" "$reads" "$writes" "$reader_wait" "$writer_wait" \
+                    "$max_reader_wait" "$max_writer_wait" "$writers_overtaken" "$readers_overtaken" "$throughput"
             fi
         done < "$RESULTS_FILE"
         
@@ -15,6 +15,11 @@
 #include <random>
 #include <atomic>
 #include <cstdlib>
+#include "readers_writers_bench.h"
+#include "readers_writers_map.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
 
 /**
  * ReadersWriterLock - A synchronization mechanism that implements the readers-writer pattern
@@ -28,13 +33,27 @@ class ReadersWriterLock {
 private:
     // SYNCHRONIZATION PRIMITIVES
     std::mutex mtx;                // Protects shared state (reader count and writer flags)
-    std::condition_variable cv;    // For threads to wait on state changes
+    std::condition_variable read_cv;   // Readers wait here for the writers to finish
+    std::condition_variable write_cv;  // Writers wait here for exclusive access
+    
+    // WHY TWO CONDITION VARIABLES?
+    // With a single condition variable every release has to notify_all(), because the
+    // releasing thread cannot pick a reader or a writer. With 100 waiting threads all 100
+    // wake up, fight for mtx, and 99 go straight back to sleep (the "thundering herd").
+    // Separate queues let a release wake exactly the threads that can make progress.
 
     // SHARED STATE (protected by mtx)
     int reader_count = 0;          // Number of active readers
     bool writer_active = false;    // Flag indicating if a writer is active
+    int waiting_readers = 0;       // Number of readers waiting for access
     int waiting_writers = 0;       // Number of writers waiting for access
     
+    // WAIT POLICY
+    // A blocked thread first spins briefly, then yields, and only then sleeps on the
+    // condition variable (see readers_writers_wait.h). Sleeping costs two context
+    // switches, which is wasted when the holder is about to release anyway.
+    WaitStrategy wait;
+    
 public:
     /**
      * read_lock() - Acquire read access to the protected resource
@@ -52,9 +71,12 @@ public:
         // Readers wait if:
         // - A writer is currently active, OR
         // - There are writers waiting (even if no writer is active)
-        cv.wait(lock, [this] { 
+        // The waiting count lets writers know whether anyone needs to be woken
+        waiting_readers++;
+        wait.wait(lock, read_cv, [this] { 
             return !writer_active && waiting_writers == 0; 
         });
+        waiting_readers--;
         
         // Increment the reader count to track active readers
         reader_count++;
@@ -77,9 +99,9 @@ public:
         reader_count--;
         
         // If we're the last reader and writers are waiting,
-        // signal that writers can proceed
+        // signal that ONE writer can proceed - only one could get in anyway
         if (reader_count == 0 && waiting_writers > 0) {
-            cv.notify_all();  // Could use notify_one() but notify_all() is safer
+            write_cv.notify_one();
         }
         
         // lock automatically releases when it goes out of scope
@@ -101,7 +123,7 @@ public:
         // KEY INSIGHT: Writers need to wait for two conditions:
         // 1. No readers are active
         // 2. No other writer is active
-        cv.wait(lock, [this] { 
+        wait.wait(lock, write_cv, [this] { 
             return reader_count == 0 && !writer_active; 
         });
         
@@ -117,7 +139,8 @@ public:
     /**
      * write_unlock() - Release exclusive write access to the protected resource
      * 
-     * This function marks the writer as inactive and notifies waiting threads.
+     * This function marks the writer as inactive and wakes exactly the threads that
+     * can proceed: one writer if any are waiting, otherwise all waiting readers.
      */
     void write_unlock() {
         std::unique_lock<std::mutex> lock(mtx);
@@ -125,13 +148,24 @@ public:
         // Mark writer as no longer active
         writer_active = false;
         
-        // Notify all waiting threads that the writer is done
-        // If there are waiting writers, only they will proceed (due to the wait condition)
-        // If no writers are waiting, readers will proceed
-        cv.notify_all();
+        // Writer preference: hand the lock to the next writer if there is one.
+        // Readers are not woken at all in that case - they could not enter anyway.
+        // Otherwise every waiting reader can enter together, so wake them all.
+        if (waiting_writers > 0) {
+            write_cv.notify_one();
+        } else if (waiting_readers > 0) {
+            read_cv.notify_all();
+        }
         
         // lock automatically releases when it goes out of scope
     }
+    
+    /**
+     * print_wait_stats() - Show how many waits ended while spinning, yielding or sleeping
+     */
+    void print_wait_stats() const {
+        wait.print_report();
+    }
 };
 
 /**
@@ -151,23 +185,24 @@ public:
      * reader() - Simulates a reader accessing the shared resource
      * 
      * @param id - The reader's identifier
-     * @return long long - The time the reader waited for access
+     * @return OpTiming - When the reader requested and was granted access
      */
-    long long reader(int id) {
+    OpTiming reader(int id) {
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Reader " << id << " wants to read." << std::endl;
         }
         
         // Measure how long the reader waits to acquire the lock
-        auto start_time = std::chrono::steady_clock::now();
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         
         // Acquire read lock
         rwlock.read_lock();
         
         // Calculate wait time
-        auto end_time = std::chrono::steady_clock::now();
-        auto wait_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
         
         // Critical section: access the shared resource
         {
@@ -181,36 +216,38 @@ public:
         
         // Release read lock
         rwlock.read_unlock();
+        timing.released = std::chrono::steady_clock::now();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Reader " << id << " finished reading." << std::endl;
         }
         
-        return wait_time;
+        return timing;
     }
     
     /**
      * writer() - Simulates a writer modifying the shared resource
      * 
      * @param id - The writer's identifier
-     * @return long long - The time the writer waited for access
+     * @return OpTiming - When the writer requested and was granted access
      */
-    long long writer(int id) {
+    OpTiming writer(int id) {
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Writer " << id << " wants to write." << std::endl;
         }
         
         // Measure how long the writer waits to acquire the lock
-        auto start_time = std::chrono::steady_clock::now();
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         
         // Acquire write lock
         rwlock.write_lock();
         
         // Calculate wait time
-        auto end_time = std::chrono::steady_clock::now();
-        auto wait_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
         
         // Critical section: modify the shared resource
         // Generate a new random value
@@ -230,13 +267,19 @@ public:
         
         // Release write lock
         rwlock.write_unlock();
+        timing.released = std::chrono::steady_clock::now();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Writer " << id << " finished writing." << std::endl;
         }
         
-        return wait_time;
+        return timing;
+    }
+    
+    // Print lock-internal statistics
+    void print_lock_stats() const {
+        rwlock.print_wait_stats();
     }
 };
 
@@ -248,71 +291,117 @@ struct Statistics {
     std::atomic<int> writers_waiting{0};   // Count of writers currently waiting
     std::atomic<long long> reader_wait_time{0}; // Total wait time for all readers
     std::atomic<long long> writer_wait_time{0}; // Total wait time for all writers
+    FairnessTracker fairness;               // Per-thread service and bypass counts
+    TraceRecorder trace;                    // Per-thread lock events for Perfetto (TRACE_FILE)
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("Educational", num_readers, num_writers, operations_per_thread) {}
 };
 
 int main() {
     // Seed for random number generation
     srand(static_cast<unsigned int>(time(nullptr)));
     
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<ReadersWriterLock>("Educational", "ReadersWriterLock");
+    }
+    
+    // WORKLOAD=map benchmarks a striped hash map built on this lock instead
+    if (map_workload_requested()) {
+        return run_map_benchmark<ReadersWriterLock>("Educational");
+    }
+    
     // Create shared resource
     SharedResource resource;
-    Statistics stats;
     
     // Create threads for readers and writers
     // Use environment variables if provided, otherwise use defaults
     const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 8;
     const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 4;
     const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 3;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
     
     std::cout << "Educational Readers-Writers Demonstration:" << std::endl;
     std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
               << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
     
     std::vector<std::thread> threads;
     
     // Lambda to simulate reader behavior with random intervals
-    auto reader_task = [&resource, &stats, operations_per_thread](int id) {
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
         
-        for (int i = 0; i < operations_per_thread; i++) {
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
             // Random delay before attempting to read
             std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
             
             // Track waiting readers
             stats.readers_waiting++;
             
             // Perform the read operation and get wait time
-            long long wait_time = resource.reader(id);
+            OpTiming timing = resource.reader(id);
             
             // Update statistics
             stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
             stats.total_reads++;
-            stats.reader_wait_time += wait_time;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
         }
     };
     
     // Lambda to simulate writer behavior with random intervals
-    auto writer_task = [&resource, &stats, operations_per_thread](int id) {
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
         
-        for (int i = 0; i < operations_per_thread; i++) {
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
             // Random delay before attempting to write
             std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
             
             // Track waiting writers
             stats.writers_waiting++;
             
             // Perform the write operation and get wait time
-            long long wait_time = resource.writer(id);
+            OpTiming timing = resource.writer(id);
             
             // Update statistics
             stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
             stats.total_writes++;
-            stats.writer_wait_time += wait_time;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
         }
     };
     
@@ -327,12 +416,12 @@ int main() {
     }
     
     // Monitor thread for displaying statistics
-    std::thread monitor([&stats, num_readers, num_writers, operations_per_thread]() {
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
         int expected_operations = (num_readers + num_writers) * operations_per_thread;
         int total_operations = 0;
         
         // Continue monitoring until all operations complete
-        while (total_operations < expected_operations) {
+        while (!run.done(total_operations, expected_operations)) {
             // Update every 2 seconds
             std::this_thread::sleep_for(std::chrono::seconds(2));
             
@@ -354,16 +443,20 @@ int main() {
             
             std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
             std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
-            std::cout << "Progress: " << (total_operations * 100) / expected_operations << "%" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
         }
     });
     
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
     // Wait for all threads to complete
     for (auto& thread : threads) {
         if (thread.joinable()) {
             thread.join();
         }
     }
+    run.finish();
     
     // Join the monitor thread
     if (monitor.joinable()) {
@@ -385,5 +478,12 @@ int main() {
     std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
     std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
     
+    // Per-thread fairness and starvation metrics
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
     return 0;
 }
@@ -0,0 +1,197 @@
+/**
+ * readers_writers_epoch.h - Epoch-based reclamation for RCU-style read paths
+ *
+ * Readers of a versioned object should not write to any shared cache line, not even a
+ * reference count. EpochDomain lets them announce "I am reading" in a slot that only their
+ * own thread writes:
+ *
+ *   read_enter()  copy the global epoch into the thread's slot
+ *   read_exit()   mark the slot quiescent again
+ *
+ * A writer swaps the published raw pointer and hands the old version to retire(), which
+ * tags it with the current epoch and advances the global epoch. A background reclaimer
+ * frees a retired version once no slot still shows an epoch at or before its tag - every
+ * reader that could have seen the old pointer has then left its read section (the grace
+ * period). The reclaimer runs every RCU_RECLAIM_MS (default 5 ms) and whenever a version
+ * is retired.
+ *
+ * Read sections must not nest, and a reader must not block on a writer while inside one.
+ * Slots are allocated on first use per thread and live as long as the domain; a thread
+ * caches the slot of the last domain it used, so the demos keep one domain per program.
+ */
+
+#ifndef READERS_WRITERS_EPOCH_H
+#define READERS_WRITERS_EPOCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class EpochDomain {
+private:
+    static constexpr uint64_t QUIESCENT = 0;
+
+    // One per reading thread, on its own cache line
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{QUIESCENT};
+        std::atomic<long long> sections{0};    // Written by the owning thread only
+        ReaderSlot* next = nullptr;
+    };
+
+    struct Retired {
+        void* object;
+        void (*destroy)(void*);
+        size_t bytes;
+        uint64_t epoch;
+        std::chrono::steady_clock::time_point retired_at;
+    };
+
+    alignas(64) std::atomic<uint64_t> global_epoch{1};
+    alignas(64) std::atomic<ReaderSlot*> slots{nullptr};   // Push-only list
+
+    std::mutex retire_mtx;                 // Protects the retired list and the reclaim statistics
+    std::condition_variable reclaim_cv;
+    std::vector<Retired> retired;
+    bool stopping = false;
+    std::chrono::milliseconds reclaim_interval;
+
+    long long retired_count = 0;
+    long long reclaimed_count = 0;
+    size_t pending_bytes = 0;
+    size_t peak_pending = 0;
+    size_t peak_pending_bytes = 0;
+    double total_grace_ms = 0;
+
+    std::thread reclaimer;
+
+    // The calling thread's slot, registered on first use
+    ReaderSlot* local_slot() {
+        thread_local const EpochDomain* owner = nullptr;
+        thread_local ReaderSlot* slot = nullptr;
+        if (owner != this) {
+            slot = new ReaderSlot;
+            ReaderSlot* head = slots.load(std::memory_order_relaxed);
+            do {
+                slot->next = head;
+            } while (!slots.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+            owner = this;
+        }
+        return slot;
+    }
+
+    // Oldest epoch any reader may still be using
+    uint64_t oldest_active_epoch() const {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t oldest = std::numeric_limits<uint64_t>::max();
+        for (ReaderSlot* slot = slots.load(std::memory_order_acquire); slot != nullptr; slot = slot->next) {
+            uint64_t epoch = slot->epoch.load(std::memory_order_acquire);
+            if (epoch != QUIESCENT) oldest = std::min(oldest, epoch);
+        }
+        return oldest;
+    }
+
+    // Free every retired version whose grace period has elapsed; retire_mtx must be held
+    void reclaim(std::unique_lock<std::mutex>& guard) {
+        uint64_t oldest = oldest_active_epoch();
+        auto now = std::chrono::steady_clock::now();
+        std::vector<Retired> expired;
+        auto still_pending = std::partition(retired.begin(), retired.end(),
+                                            [oldest](const Retired& r) { return r.epoch >= oldest; });
+        expired.assign(still_pending, retired.end());
+        retired.erase(still_pending, retired.end());
+        for (const Retired& r : expired) {
+            pending_bytes -= r.bytes;
+            total_grace_ms += std::chrono::duration<double, std::milli>(now - r.retired_at).count();
+        }
+        reclaimed_count += expired.size();
+
+        guard.unlock();
+        for (const Retired& r : expired) r.destroy(r.object);
+        guard.lock();
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> guard(retire_mtx);
+        while (!stopping) {
+            reclaim_cv.wait_for(guard, reclaim_interval);
+            if (!retired.empty()) reclaim(guard);
+        }
+    }
+
+public:
+    EpochDomain()
+        : reclaim_interval(std::getenv("RCU_RECLAIM_MS") ? std::stoi(std::getenv("RCU_RECLAIM_MS")) : 5) {
+        reclaimer = std::thread(&EpochDomain::run, this);
+    }
+
+    // Callers must have stopped reading; anything still retired is freed here
+    ~EpochDomain() {
+        {
+            std::lock_guard<std::mutex> guard(retire_mtx);
+            stopping = true;
+        }
+        reclaim_cv.notify_one();
+        reclaimer.join();
+        for (const Retired& r : retired) r.destroy(r.object);
+        for (ReaderSlot* slot = slots.load(); slot != nullptr;) {
+            ReaderSlot* next = slot->next;
+            delete slot;
+            slot = next;
+        }
+    }
+
+    void read_enter() {
+        ReaderSlot* slot = local_slot();
+        // A seq_cst exchange orders the announcement before the caller's load of the published
+        // pointer; it is cheaper than a separate full fence and touches only our own line
+        slot->epoch.exchange(global_epoch.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+        slot->sections.store(slot->sections.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void read_exit() {
+        local_slot()->epoch.store(QUIESCENT, std::memory_order_release);
+    }
+
+    // Hand over a version that has already been unpublished; it is deleted after a grace period
+    template <typename T>
+    void retire(T* object, size_t bytes) {
+        std::lock_guard<std::mutex> guard(retire_mtx);
+        // Readers that may hold `object` announced an epoch no later than this one
+        uint64_t epoch = global_epoch.fetch_add(1, std::memory_order_seq_cst);
+        retired.push_back({object, [](void* p) { delete static_cast<T*>(p); }, bytes, epoch,
+                           std::chrono::steady_clock::now()});
+        retired_count++;
+        pending_bytes += bytes;
+        peak_pending = std::max(peak_pending, retired.size());
+        peak_pending_bytes = std::max(peak_pending_bytes, pending_bytes);
+        reclaim_cv.notify_one();
+    }
+
+    void print_report() {
+        std::lock_guard<std::mutex> guard(retire_mtx);
+        long long read_sections = 0;
+        int reader_slots = 0;
+        for (ReaderSlot* slot = slots.load(); slot != nullptr; slot = slot->next) {
+            read_sections += slot->sections.load(std::memory_order_relaxed);
+            reader_slots++;
+        }
+        std::cout << "\n----- EPOCH RECLAMATION -----" << std::endl;
+        std::cout << "Read sections: " << read_sections << " in " << reader_slots << " thread slots (global epoch "
+                  << global_epoch << ")" << std::endl;
+        std::cout << "Versions retired/reclaimed: " << retired_count << " / " << reclaimed_count << std::endl;
+        std::cout << "Retired versions awaiting reclamation (now/peak): " << retired.size() << " / " << peak_pending << std::endl;
+        std::cout << "Retired memory (now/peak): " << pending_bytes << " / " << peak_pending_bytes << " bytes" << std::endl;
+        std::cout << "Avg grace period: " << (reclaimed_count > 0 ? total_grace_ms / reclaimed_count : 0.0) << " ms" << std::endl;
+    }
+};
+
+#endif // READERS_WRITERS_EPOCH_H
@@ -4,85 +4,119 @@
 #include <condition_variable>
 #include <chrono>
 #include <vector>
-#include <queue>
 #include <random>
 #include <atomic>
-#include <memory>
 #include <cstdlib> // For getenv, stoi
-
-enum class RequestType { READ, WRITE };
+#include "readers_writers_async.h"
+#include "readers_writers_bench.h"
+#include "readers_writers_combining.h"
+#include "readers_writers_fifo.h"
+#include "readers_writers_handoff.h"
+#include "readers_writers_map.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
 
 // A fair implementation of Readers-Writers problem that prevents starvation
-// Uses a FIFO queue to ensure fair access for both readers and writers
+// Uses a FIFO queue (readers_writers_fifo.h) to ensure fair access for both readers and writers
+//
+// Strict FIFO only admits the contiguous run of readers at the head of the queue, so an
+// alternating R/W/R/W arrival pattern runs fully serially. An optional admission window
+// lets a reader group also pick up readers further back in the queue:
+//   FAIR_READ_WINDOW_MS   Readers that arrived within this time of the group's first reader
+//   FAIR_READ_LOOKAHEAD   Readers at most this many queue positions behind the head
+//   FAIR_WRITER_BOUND_MS  Never pass a writer that has already waited this long (default 500)
+// Either of the first two enables the window; if both are set a reader must satisfy both.
 class FairReadersWriterLock {
 private:
-    struct Request {
-        RequestType type;
-        std::shared_ptr<std::condition_variable> cv;
-        bool granted = false;
-        
-        Request(RequestType t) : type(t), cv(std::make_shared<std::condition_variable>()) {}
-    };
-
+    // Exclusion follows from the grants made in process_queue() alone
     std::mutex mtx;                // Protects access to shared data
-    std::mutex resource_mutex;     // Provides exclusive access to the resource
-    std::queue<std::shared_ptr<Request>> request_queue; // Queue of pending requests
+    FifoGrantQueue grants;         // Queue of pending requests and the active holders
+    
+    // Reader group admission window (disabled when both limits are 0)
+    std::chrono::milliseconds read_window;
+    size_t read_lookahead;
+    std::chrono::milliseconds writer_bound;
+    long long early_admissions = 0; // Readers admitted past a queued writer
+    
+    WaitStrategy wait;             // Spin-then-park policy for blocked threads
+    ResourceGate gate;             // Old writer-side resource lock, only with RESOURCE_GATE=1
+    LockStateSnapshot snapshot;    // Lock-free copy of the state for monitoring
+    
+    // Publish the current state for queue_size()/state(); called with mtx held
+    void publish_state() {
+        LockState state;
+        state.active_readers = grants.active_readers;
+        state.writer_active = grants.writer_active;
+        state.waiting_readers = grants.waiting_readers;
+        state.waiting_writers = grants.waiting_writers;
+        state.queue_depth = grants.queue.size();
+        snapshot.publish(state);
+    }
+    
+    static long long env_or(const char* name, long long fallback) {
+        return std::getenv(name) ? std::stoll(std::getenv(name)) : fallback;
+    }
     
-    int active_readers = 0;        // Number of active readers
-    bool writer_active = false;    // Flag to check if writer is active
+    bool window_enabled() const {
+        return read_window.count() > 0 || read_lookahead > 0;
+    }
+    
+    // Extend a freshly admitted reader group with readers further back in the queue
+    void admit_window(std::chrono::steady_clock::time_point group_start) {
+        auto now = std::chrono::steady_clock::now();
+        auto& queue = grants.queue;
+        size_t limit = read_lookahead > 0 ? std::min(read_lookahead, queue.size()) : queue.size();
+        
+        for (size_t i = 0; i < limit && i < queue.size(); ) {
+            FifoRequest* request = queue[i];
+            if (request->type == RequestType::WRITE) {
+                // Do not overtake a writer that has already waited too long
+                if (now - request->enqueued >= writer_bound) break;
+                i++;
+                continue;
+            }
+            if (read_window.count() > 0 && request->enqueued - group_start > read_window) break;
+            
+            queue.erase(queue.begin() + i);
+            limit--;
+            grants.grant_read(request);
+            early_admissions++;
+        }
+    }
     
     // Process the request queue to grant access when possible
     void process_queue() {
-        if (request_queue.empty()) return;
-
-        auto request = request_queue.front();
-        
-        if (request->type == RequestType::READ) {
-            // Grant read access if no writer is active
-            if (!writer_active) {
-                request_queue.pop();
-                active_readers++;
-                request->granted = true;
-                request->cv->notify_one();
-                
-                // Process additional read requests that can be granted simultaneously
-                while (!request_queue.empty() && request_queue.front()->type == RequestType::READ) {
-                    auto next_read = request_queue.front();
-                    request_queue.pop();
-                    active_readers++;
-                    next_read->granted = true;
-                    next_read->cv->notify_one();
-                }
-            }
-        } else { // RequestType::WRITE
-            // Grant write access if no readers or writers are active
-            if (active_readers == 0 && !writer_active) {
-                request_queue.pop();
-                writer_active = true;
-                request->granted = true;
-                request->cv->notify_one();
-            }
+        FifoRequest* group = grants.process();
+        
+        // Optionally admit readers queued behind the next writer as well
+        if (group != nullptr && window_enabled()) {
+            admit_window(group->enqueued);
         }
+        
+        publish_state();
     }
     
 public:
+    FairReadersWriterLock()
+        : read_window(env_or("FAIR_READ_WINDOW_MS", 0)),
+          read_lookahead(env_or("FAIR_READ_LOOKAHEAD", 0)),
+          writer_bound(env_or("FAIR_WRITER_BOUND_MS", 500)) {}
+    
     // Reader tries to acquire the lock
     void read_lock() {
         std::unique_lock<std::mutex> lock(mtx);
         
         // Create a read request
-        auto request = std::make_shared<Request>(RequestType::READ);
-        request_queue.push(request);
+        FifoRequest request(RequestType::READ);
+        grants.enqueue(&request);
         
         // Try to process the queue (may grant this request immediately)
         process_queue();
         
         // Wait if request not granted yet
-        while (!request->granted) {
-            request->cv->wait(lock);
-        }
+        wait.wait(lock, request.cv, [&request] { return request.granted; });
         
-        // Note: First reader has already acquired the resource mutex in process_queue
         lock.unlock();
     }
     
@@ -91,12 +125,7 @@ public:
         std::unique_lock<std::mutex> lock(mtx);
         
         // Decrement the reader count
-        active_readers--;
-        
-        // Last reader releases the resource lock
-        if (active_readers == 0) {
-            resource_mutex.unlock();
-        }
+        grants.active_readers--;
         
         // Process the next request in the queue
         process_queue();
@@ -109,21 +138,17 @@ public:
         std::unique_lock<std::mutex> lock(mtx);
         
         // Create a write request
-        auto request = std::make_shared<Request>(RequestType::WRITE);
-        request_queue.push(request);
+        FifoRequest request(RequestType::WRITE);
+        grants.enqueue(&request);
         
         // Try to process the queue (may grant this request immediately)
         process_queue();
         
         // Wait if request not granted yet
-        while (!request->granted) {
-            request->cv->wait(lock);
-        }
+        wait.wait(lock, request.cv, [&request] { return request.granted; });
         
         lock.unlock();
-        
-        // Acquire exclusive access to the resource
-        resource_mutex.lock();
+        gate.acquire();
     }
     
     // Writer releases the lock
@@ -131,10 +156,8 @@ public:
         std::unique_lock<std::mutex> lock(mtx);
         
         // Mark writer as inactive
-        writer_active = false;
-        
-        // Release exclusive access to the resource
-        resource_mutex.unlock();
+        grants.writer_active = false;
+        gate.release();
         
         // Process the next request in the queue
         process_queue();
@@ -142,11 +165,25 @@ public:
         lock.unlock();
     }
     
-    // Get queue size for monitoring
+    // Get queue size for monitoring; reads the published snapshot, never mtx
     size_t queue_size() const {
-        // Use const_cast since this is just for monitoring and doesn't modify the queue
-        std::lock_guard<std::mutex> lock(*const_cast<std::mutex*>(&mtx));
-        return request_queue.size();
+        return snapshot.load().queue_depth;
+    }
+    
+    // Full lock state for monitoring (approximate: may lag the lock by one update)
+    LockState state() const {
+        return snapshot.load();
+    }
+    
+    // Print how the waits were resolved
+    void print_wait_stats() const {
+        if (window_enabled()) {
+            std::cout << "\n----- READER ADMISSION WINDOW -----" << std::endl;
+            std::cout << "Window: " << read_window.count() << " ms, lookahead " << read_lookahead
+                      << " positions, writer bound " << writer_bound.count() << " ms" << std::endl;
+            std::cout << "Readers admitted past a queued writer: " << early_admissions << std::endl;
+        }
+        wait.print_report();
     }
 };
 
@@ -155,11 +192,31 @@ class SharedResource {
 private:
     int data = 0;
     FairReadersWriterLock rwlock;
+    WriteCombiner<FairReadersWriterLock> combiner{rwlock};  // Batches writers when COMBINE_WRITES=1
     std::mutex print_mutex;  // For synchronized console output
     
+    // Apply a batch of combined or queued writes; runs with the write lock held, in the
+    // combining writer or in the async applier thread
+    void apply_batch(const std::vector<WriteCombiner<FairReadersWriterLock>::Update>& batch) {
+        for (const auto& update : batch) {
+            {
+                std::lock_guard<std::mutex> print_lock(print_mutex);
+                std::cout << "Writer " << update.first << " is writing data: " << update.second
+                          << " (batch of " << batch.size() << ")" << std::endl;
+            }
+            data = update.second;
+        }
+        
+        // One simulated processing phase for the whole batch
+        std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
+    }
+    
+    // Applier thread for ASYNC_WRITES=1; declared last so it stops before the members it uses
+    AsyncWriteQueue<FairReadersWriterLock> async_writes{rwlock, [this](const auto& batch) { apply_batch(batch); }};
+    
 public:
     // Reader function: reads data from the shared resource
-    int reader(int id) {
+    OpTiming reader(int id) {
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Reader " << id << " wants to read (queue size: " 
@@ -167,10 +224,11 @@ public:
         }
         
         // Acquire read lock
-        auto start_time = std::chrono::steady_clock::now();
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         rwlock.read_lock();
-        auto end_time = std::chrono::steady_clock::now();
-        auto wait_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
@@ -183,28 +241,63 @@ public:
         
         // Release read lock
         rwlock.read_unlock();
+        timing.released = std::chrono::steady_clock::now();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Reader " << id << " finished reading." << std::endl;
         }
         
-        return wait_time;
+        return timing;
+    }
+    
+    bool async_writes_enabled() const {
+        return async_writes.enabled();
+    }
+    
+    // Async writer function (ASYNC_WRITES=1): queues the update for the applier thread and
+    // returns at once; the future becomes ready when the update has been applied
+    std::future<void> writer_async(int id, OpTiming& timing) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " wants to write (queue size: " 
+                      << rwlock.queue_size() << ")." << std::endl;
+        }
+        
+        timing.requested = std::chrono::steady_clock::now();
+        std::future<void> applied = async_writes.write(id, rand() % 1000);
+        timing.granted = timing.released = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " queued its update." << std::endl;
+        }
+        return applied;
     }
     
     // Writer function: modifies the shared resource
-    int writer(int id) {
+    OpTiming writer(int id) {
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Writer " << id << " wants to write (queue size: " 
                       << rwlock.queue_size() << ")." << std::endl;
         }
         
+        if (combiner.enabled()) {
+            // Publish the update and let a combining writer apply it
+            OpTiming timing = combiner.write(id, rand() % 1000, [this](const auto& batch) { apply_batch(batch); });
+            {
+                std::lock_guard<std::mutex> print_lock(print_mutex);
+                std::cout << "Writer " << id << " finished writing." << std::endl;
+            }
+            return timing;
+        }
+        
         // Acquire write lock
-        auto start_time = std::chrono::steady_clock::now();
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         rwlock.write_lock();
-        auto end_time = std::chrono::steady_clock::now();
-        auto wait_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
         
         // Simulate writing process
         int new_value = rand() % 1000;
@@ -223,19 +316,32 @@ public:
         
         // Release write lock
         rwlock.write_unlock();
+        timing.released = std::chrono::steady_clock::now();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Writer " << id << " finished writing." << std::endl;
         }
         
-        return wait_time;
+        return timing;
     }
     
     // Get the current data value
     int get_data() const {
         return data;
     }
+    
+    // Wait until every queued async write has been applied
+    void flush_writes() {
+        async_writes.flush();
+    }
+    
+    // Print lock-internal statistics
+    void print_lock_stats() const {
+        async_writes.print_report();
+        combiner.print_report();
+        rwlock.print_wait_stats();
+    }
 };
 
 // Statistics for the demonstration
@@ -246,24 +352,51 @@ struct Statistics {
     std::atomic<int> writers_waiting{0};
     std::atomic<long long> reader_wait_time{0};
     std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("Fair/Queue-based", num_readers, num_writers, operations_per_thread) {}
 };
 
 int main() {
     // Seed for random number generation
     srand(static_cast<unsigned int>(time(nullptr)));
     
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<FairReadersWriterLock>("Fair/Queue-based", "FairReadersWriterLock", "deque blocks for the request queue; the requests live on the waiters' stacks");
+    }
+    
+    // WORKLOAD=map benchmarks a striped hash map built on this lock instead
+    if (map_workload_requested()) {
+        return run_map_benchmark<FairReadersWriterLock>("Fair/Queue-based");
+    }
+    
+    // WORKLOAD=handoff measures reader-to-writer handoff latency (RESOURCE_GATE=1: old protocol)
+    if (handoff_workload_requested()) {
+        return run_handoff_benchmark<FairReadersWriterLock>("Fair/Queue-based");
+    }
+    
     // Create shared resource
     SharedResource resource;
-    Statistics stats;
     
     // Create threads for readers and writers
     // Use environment variables if provided, otherwise use defaults
     const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
     const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
     const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
     
     std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
               << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
     
     std::vector<std::thread> threads;
     
@@ -272,39 +405,75 @@ int main() {
               << num_writers << " writers." << std::endl;
     
     // Lambda to simulate reader behavior with random intervals
-    auto reader_task = [&resource, &stats, operations_per_thread](int id) {
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
         
-        for (int i = 0; i < operations_per_thread; i++) {
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
             // Random delay before attempting to read
             std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
             
             stats.readers_waiting++;
-            long long wait_time = resource.reader(id);
+            OpTiming timing = resource.reader(id);
             stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
             stats.total_reads++;
-            stats.reader_wait_time += wait_time;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
         }
     };
     
     // Lambda to simulate writer behavior with random intervals
-    auto writer_task = [&resource, &stats, operations_per_thread](int id) {
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
         
-        for (int i = 0; i < operations_per_thread; i++) {
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        std::future<void> pending;   // Last async write, at most one in flight per writer
+        
+        for (int i = 0; run.keep_running(i); i++) {
             // Random delay before attempting to write
             std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
             
             stats.writers_waiting++;
-            long long wait_time = resource.writer(id);
+            OpTiming timing;
+            if (resource.async_writes_enabled()) {
+                // Confirm the previous update was applied before queueing the next one
+                if (pending.valid()) pending.get();
+                pending = resource.writer_async(id, timing);
+            } else {
+                timing = resource.writer(id);
+            }
             stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
             stats.total_writes++;
-            stats.writer_wait_time += wait_time;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
         }
+        
+        // Confirm that the last queued update has been applied as well
+        if (pending.valid()) pending.get();
     };
     
     // Start reader threads
@@ -318,11 +487,11 @@ int main() {
     }
     
     // Monitor thread for displaying statistics
-    std::thread monitor([&stats, num_readers, num_writers, operations_per_thread]() {
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
         int expected_operations = (num_readers + num_writers) * operations_per_thread;
         int total_operations = 0;
         
-        while (total_operations < expected_operations) {
+        while (!run.done(total_operations, expected_operations)) {
             std::this_thread::sleep_for(std::chrono::seconds(2));
             total_operations = stats.total_reads + stats.total_writes;
             
@@ -340,16 +509,21 @@ int main() {
             
             std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
             std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
-            std::cout << "Progress: " << (total_operations * 100) / expected_operations << "%" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
         }
     });
     
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
     // Wait for all threads to complete
     for (auto& thread : threads) {
         if (thread.joinable()) {
             thread.join();
         }
     }
+    run.finish();
+    resource.flush_writes();
     
     if (monitor.joinable()) {
         monitor.join();
@@ -369,5 +543,11 @@ int main() {
     std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
     std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
     
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
     return 0;
 }
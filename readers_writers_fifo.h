@@ -0,0 +1,94 @@
+/**
+ * readers_writers_fifo.h - FIFO granting of read and write requests
+ *
+ * The queue discipline of the fair lock, kept separate so that every lock head of the lock
+ * manager can use it as well. A FifoGrantQueue holds the requests of one lock in arrival
+ * order and grants from the head: a writer once nothing is active, or the whole run of
+ * readers at the head while no writer is active. Requests live on the waiting thread's
+ * stack and are woken through their own condition variable, so a grant wakes exactly the
+ * threads it admitted.
+ *
+ * FifoGrantQueue does no locking of its own; every call must hold the mutex the waiters
+ * use with their condition variables.
+ */
+
+#ifndef READERS_WRITERS_FIFO_H
+#define READERS_WRITERS_FIFO_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+
+enum class RequestType { READ, WRITE };
+
+struct FifoRequest {
+    RequestType type;
+    bool granted = false;
+    std::condition_variable cv;
+    std::chrono::steady_clock::time_point enqueued = std::chrono::steady_clock::now();
+
+    explicit FifoRequest(RequestType t) : type(t) {}
+};
+
+class FifoGrantQueue {
+public:
+    std::deque<FifoRequest*> queue;    // Waiting requests, oldest first
+    int active_readers = 0;            // Number of active readers
+    bool writer_active = false;        // Flag to check if writer is active
+    int waiting_readers = 0;           // Read requests still in the queue
+    int waiting_writers = 0;           // Write requests still in the queue
+
+    void enqueue(FifoRequest* request) {
+        queue.push_back(request);
+        (request->type == RequestType::READ ? waiting_readers : waiting_writers)++;
+    }
+
+    // Grant one queued read request (already removed from the queue)
+    void grant_read(FifoRequest* request) {
+        active_readers++;
+        waiting_readers--;
+        request->granted = true;
+        request->cv.notify_one();
+    }
+
+    // Grant whatever the head of the queue allows. Returns the first reader of a newly
+    // admitted reader group, or nullptr if no readers were admitted.
+    FifoRequest* process() {
+        if (queue.empty()) return nullptr;
+
+        FifoRequest* request = queue.front();
+
+        if (request->type == RequestType::READ) {
+            // Grant read access if no writer is active
+            if (!writer_active) {
+                queue.pop_front();
+                grant_read(request);
+
+                // Process additional read requests that can be granted simultaneously
+                while (!queue.empty() && queue.front()->type == RequestType::READ) {
+                    FifoRequest* next_read = queue.front();
+                    queue.pop_front();
+                    grant_read(next_read);
+                }
+                return request;
+            }
+        } else { // RequestType::WRITE
+            // Grant write access if no readers or writers are active
+            if (active_readers == 0 && !writer_active) {
+                queue.pop_front();
+                writer_active = true;
+                waiting_writers--;
+                request->granted = true;
+                request->cv.notify_one();
+            }
+        }
+        return nullptr;
+    }
+
+    // Nothing held and nobody waiting
+    bool idle() const {
+        return queue.empty() && active_readers == 0 && !writer_active;
+    }
+};
+
+#endif // READERS_WRITERS_FIFO_H
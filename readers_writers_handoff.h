@@ -0,0 +1,133 @@
+/**
+ * readers_writers_handoff.h - Reader-to-writer handoff latency
+ *
+ * The writer-priority, readers-priority and fair locks used to hold a second resource
+ * mutex besides the one protecting their state: the first reader (or the writer) took it
+ * once admitted and the last reader (or the writer) released it, so every reader-to-writer
+ * transition had one more blocking step. The state alone already decides who may enter,
+ * and the extra lock was removed. This header measures what that saved.
+ *
+ * ResourceGate puts the old step back when RESOURCE_GATE=1; otherwise it is an empty
+ * pointer and every call returns at once. A semaphore stands in for the old mutex because
+ * its release may legally come from a different thread than its acquire.
+ *
+ * With WORKLOAD=handoff a program runs run_handoff_benchmark() instead of its
+ * demonstration. Each round HANDOFF_READERS readers (default 2) take the read lock, one
+ * writer queues for the write lock, and the readers release it after HANDOFF_HOLD_US
+ * (default 200) so the writer has blocked by then. The handoff latency is the time from
+ * the last reader's read_unlock() call to the writer's return from write_lock(), over
+ * HANDOFF_ROUNDS rounds (default 2000).
+ */
+
+#ifndef READERS_WRITERS_HANDOFF_H
+#define READERS_WRITERS_HANDOFF_H
+
+#include <semaphore.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ResourceGate {
+private:
+    std::unique_ptr<sem_t> sem;     // Only allocated with RESOURCE_GATE=1
+
+public:
+    ResourceGate() {
+        if (std::getenv("RESOURCE_GATE") && std::string(std::getenv("RESOURCE_GATE")) != "0") {
+            sem.reset(new sem_t);
+            sem_init(sem.get(), 0, 1);
+        }
+    }
+
+    ~ResourceGate() {
+        if (sem) sem_destroy(sem.get());
+    }
+
+    ResourceGate(const ResourceGate&) = delete;
+    ResourceGate& operator=(const ResourceGate&) = delete;
+
+    void acquire() {
+        if (sem) while (sem_wait(sem.get()) != 0) {}
+    }
+
+    void release() {
+        if (sem) sem_post(sem.get());
+    }
+
+    bool enabled() const {
+        return sem != nullptr;
+    }
+};
+
+inline bool handoff_workload_requested() {
+    return std::getenv("WORKLOAD") && std::string(std::getenv("WORKLOAD")) == "handoff";
+}
+
+// Reader-to-writer handoff latency of `Lock`; `policy` names the lock in the report
+template <typename Lock>
+int run_handoff_benchmark(const char* policy) {
+    auto env_or = [](const char* name, long long fallback) {
+        return std::getenv(name) ? std::stoll(std::getenv(name)) : fallback;
+    };
+    const int readers = std::max(1LL, env_or("HANDOFF_READERS", 2));
+    const int rounds = std::max(1LL, env_or("HANDOFF_ROUNDS", 2000));
+    const auto hold = std::chrono::microseconds(env_or("HANDOFF_HOLD_US", 200));
+    using Clock = std::chrono::steady_clock;
+
+    Lock lock;
+    bool gated = ResourceGate().enabled();
+    std::atomic<int> round{0};                      // Round the readers may start
+    std::atomic<int> holding{0};                    // Readers holding the read lock
+    std::atomic<bool> writer_queued{false};
+    std::atomic<long long> released_ns{0};          // Last reader's release, since the epoch
+    std::vector<double> latencies_us;
+    latencies_us.reserve(rounds);
+
+    std::vector<std::thread> reader_threads;
+    for (int t = 0; t < readers; t++) {
+        reader_threads.emplace_back([&] {
+            for (int r = 1; r <= rounds; r++) {
+                while (round.load(std::memory_order_acquire) < r) std::this_thread::yield();
+                lock.read_lock();
+                holding.fetch_add(1, std::memory_order_acq_rel);
+                while (!writer_queued.load(std::memory_order_acquire)) std::this_thread::yield();
+                std::this_thread::sleep_for(hold);
+                if (holding.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    released_ns.store(Clock::now().time_since_epoch().count(), std::memory_order_release);
+                }
+                lock.read_unlock();
+            }
+        });
+    }
+
+    for (int r = 1; r <= rounds; r++) {
+        writer_queued.store(false, std::memory_order_release);
+        round.store(r, std::memory_order_release);
+        while (holding.load(std::memory_order_acquire) < readers) std::this_thread::yield();
+        writer_queued.store(true, std::memory_order_release);
+        lock.write_lock();
+        long long acquired = Clock::now().time_since_epoch().count();
+        latencies_us.push_back(std::chrono::duration<double, std::micro>(
+            Clock::duration(acquired - released_ns.load(std::memory_order_acquire))).count());
+        lock.write_unlock();
+    }
+    for (auto& thread : reader_threads) thread.join();
+
+    std::sort(latencies_us.begin(), latencies_us.end());
+    double total = 0;
+    for (double latency : latencies_us) total += latency;
+    std::cout << "\n----- HANDOFF BENCHMARK -----" << std::endl;
+    std::cout << "Lock policy: " << policy << " (resource gate: " << (gated ? "on" : "off") << ")" << std::endl;
+    std::cout << "Rounds: " << rounds << ", readers: " << readers << ", read hold: " << hold.count() << " us" << std::endl;
+    std::cout << "Reader-to-writer handoff: avg " << total / rounds << " us, median " << latencies_us[rounds / 2]
+              << " us, p99 " << latencies_us[rounds * 99 / 100] << " us, max " << latencies_us.back() << " us" << std::endl;
+    return 0;
+}
+
+#endif // READERS_WRITERS_HANDOFF_H
@@ -0,0 +1,522 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <algorithm>
+#include <string>
+#include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_hierarchy.h"
+#include "readers_writers_map.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
+
+// A table of HIER_PARTITIONS partitions (default 8) with HIER_ROWS rows each (default 64),
+// locked at all three levels through readers_writers_hierarchy.h. Every row starts at
+// INITIAL_VALUE and updates only move amounts between rows of one partition, so every
+// partition and the table keep a constant sum; scans check it to prove they saw no
+// partial update. With `coarse` set every operation locks only the table in S or X,
+// which is the single-lock baseline the hierarchy is measured against.
+class Table {
+private:
+    static constexpr int INITIAL_VALUE = 100;
+    
+    WaitStrategy wait;                          // Shared by every node of the table
+    std::deque<HierarchyNode> nodes;            // Table, partitions, rows
+    HierarchyNode* root;
+    std::vector<HierarchyNode*> partitions;
+    std::vector<HierarchyNode*> rows;           // Partition-major
+    std::vector<int> values;
+    int partition_count;
+    int rows_per_partition;
+    bool coarse;
+    std::atomic<long long> inconsistent_scans{0};
+    
+    int row_index(int partition, int row) const {
+        return partition * rows_per_partition + row;
+    }
+    
+public:
+    Table(int partition_count, int rows_per_partition, bool coarse)
+        : partition_count(std::max(1, partition_count)),
+          rows_per_partition(std::max(2, rows_per_partition)),
+          coarse(coarse) {
+        nodes.emplace_back(wait);
+        root = &nodes.back();
+        for (int p = 0; p < this->partition_count; p++) {
+            nodes.emplace_back(wait);
+            nodes.back().parent = root;
+            partitions.push_back(&nodes.back());
+        }
+        for (int p = 0; p < this->partition_count; p++) {
+            for (int r = 0; r < this->rows_per_partition; r++) {
+                nodes.emplace_back(wait);
+                nodes.back().parent = partitions[p];
+                rows.push_back(&nodes.back());
+            }
+        }
+        values.assign(rows.size(), INITIAL_VALUE);
+    }
+    
+    int partitions_in_table() const { return partition_count; }
+    int rows_in_partition() const { return rows_per_partition; }
+    
+    // Full scan: S on the table. Returns the total; hold(total) runs with the locks held.
+    template <typename Hold>
+    long long scan_table(Hold hold) {
+        HierarchyGuard guard(*root, IntentionMode::S);
+        long long sum = 0;
+        for (int value : values) sum += value;
+        hold(sum);
+        if (sum != static_cast<long long>(INITIAL_VALUE) * static_cast<long long>(values.size())) inconsistent_scans++;
+        return sum;
+    }
+    
+    // Partition scan: IS on the table, S on the partition. Returns the partition total;
+    // hold(total) runs with the locks held.
+    template <typename Hold>
+    long long scan_partition(int partition, Hold hold) {
+        HierarchyGuard guard(coarse ? *root : *partitions[partition], IntentionMode::S);
+        long long sum = 0;
+        for (int r = 0; r < rows_per_partition; r++) sum += values[row_index(partition, r)];
+        hold(sum);
+        if (sum != static_cast<long long>(INITIAL_VALUE) * rows_per_partition) inconsistent_scans++;
+        return sum;
+    }
+    
+    // Point read: IS on table and partition, S on the row; hold(value) runs with the locks held
+    template <typename Hold>
+    int read_row(int partition, int row, Hold hold) {
+        HierarchyGuard guard(coarse ? *root : *rows[row_index(partition, row)], IntentionMode::S);
+        int value = values[row_index(partition, row)];
+        hold(value);
+        return value;
+    }
+    
+    // Point update: IX on table and partition, X on both rows (ascending)
+    template <typename Hold>
+    void transfer(int partition, int from, int to, int amount, Hold hold) {
+        if (from == to) return;
+        HierarchyGuard guard(coarse ? *root : *partitions[partition], coarse ? IntentionMode::X : IntentionMode::IX);
+        guard.lock_descendant(*rows[row_index(partition, std::min(from, to))], IntentionMode::X);
+        guard.lock_descendant(*rows[row_index(partition, std::max(from, to))], IntentionMode::X);
+        values[row_index(partition, from)] -= amount;
+        hold();
+        values[row_index(partition, to)] += amount;
+    }
+    
+    // Scan and update: SIX on the partition, so other readers may still read its rows while
+    // it is scanned, then X on the largest and smallest row to even them out
+    template <typename Hold>
+    void rebalance(int partition, Hold hold) {
+        HierarchyGuard guard(coarse ? *root : *partitions[partition], coarse ? IntentionMode::X : IntentionMode::SIX);
+        int largest = 0, smallest = 0;
+        for (int r = 1; r < rows_per_partition; r++) {
+            if (values[row_index(partition, r)] > values[row_index(partition, largest)]) largest = r;
+            if (values[row_index(partition, r)] < values[row_index(partition, smallest)]) smallest = r;
+        }
+        if (largest == smallest) return;
+        guard.lock_descendant(*rows[row_index(partition, std::min(largest, smallest))], IntentionMode::X);
+        guard.lock_descendant(*rows[row_index(partition, std::max(largest, smallest))], IntentionMode::X);
+        int amount = (values[row_index(partition, largest)] - values[row_index(partition, smallest)]) / 2;
+        values[row_index(partition, largest)] -= amount;
+        hold();
+        values[row_index(partition, smallest)] += amount;
+    }
+    
+    void print_report() {
+        const char* levels[] = {"Table", "Partition", "Row"};
+        long long grants[3][INTENTION_MODES] = {};
+        long long waits[3][INTENTION_MODES] = {};
+        root->lock.add_stats(grants[0], waits[0]);
+        for (HierarchyNode* node : partitions) node->lock.add_stats(grants[1], waits[1]);
+        for (HierarchyNode* node : rows) node->lock.add_stats(grants[2], waits[2]);
+        
+        std::cout << "\n----- HIERARCHICAL LOCK -----" << std::endl;
+        std::cout << "Locking: " << (coarse ? "table only (coarse)" : "multi-granularity") << ", "
+                  << partition_count << " partitions x " << rows_per_partition << " rows" << std::endl;
+        for (int level = 0; level < 3; level++) {
+            std::cout << levels[level] << " grants (waited):";
+            for (int mode = 0; mode < INTENTION_MODES; mode++) {
+                std::cout << " " << intention_mode_name(static_cast<IntentionMode>(mode)) << " "
+                          << grants[level][mode] << " (" << waits[level][mode] << ")";
+            }
+            std::cout << std::endl;
+        }
+        std::cout << "Inconsistent scans: " << inconsistent_scans << std::endl;
+        wait.print_report();
+    }
+};
+
+static long long env_or(const char* name, long long fallback) {
+    return std::getenv(name) ? std::stoll(std::getenv(name)) : fallback;
+}
+
+// Shared resource: the table. Readers scan the table, scan a partition or read a row;
+// writers move amounts between rows or rebalance a partition under SIX.
+class SharedResource {
+private:
+    Table table;
+    std::mutex print_mutex;  // For synchronized console output
+    
+public:
+    SharedResource()
+        : table(env_or("HIER_PARTITIONS", 8), env_or("HIER_ROWS", 64), env_or("HIER_COARSE", 0) != 0) {}
+    
+    // Reader function: one scan or point read at a random granularity
+    OpTiming reader(int id) {
+        int kind = rand() % 10;     // 1 in 10 table scans, 3 in 10 partition scans, the rest rows
+        int partition = rand() % table.partitions_in_table();
+        int row = rand() % table.rows_in_partition();
+        const char* what = kind == 0 ? "the table" : kind < 4 ? "a partition" : "a row";
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " wants to read " << what << "." << std::endl;
+        }
+        
+        // Acquire the path and read; timing.granted is taken once every lock is held
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        auto hold = [&](long long result) {
+            timing.granted = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> print_lock(print_mutex);
+                std::cout << "Reader " << id << " is reading data: " << result << " (" << what
+                          << ", waited " << timing.wait_ms() << "ms)" << std::endl;
+            }
+            // Simulate reading process
+            std::this_thread::sleep_for(std::chrono::milliseconds(100 + (rand() % 900)));
+        };
+        if (kind == 0) {
+            table.scan_table(hold);
+        } else if (kind < 4) {
+            table.scan_partition(partition, hold);
+        } else {
+            table.read_row(partition, row, hold);
+        }
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " finished reading." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Writer function: a point transfer, or a rebalance of a whole partition
+    OpTiming writer(int id) {
+        bool rebalance = rand() % 10 < 3;
+        int partition = rand() % table.partitions_in_table();
+        int from = rand() % table.rows_in_partition();
+        int to = rand() % table.rows_in_partition();
+        int amount = rand() % 50;
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " wants to " << (rebalance ? "rebalance partition " : "update partition ")
+                      << partition << "." << std::endl;
+        }
+        
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        timing.granted = timing.requested;          // A transfer between a row and itself locks nothing
+        auto hold = [&] {
+            timing.granted = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> print_lock(print_mutex);
+                std::cout << "Writer " << id << " is writing data: " << (rebalance ? "rebalance" : "transfer of ")
+                          << (rebalance ? "" : std::to_string(amount)) << " (partition " << partition
+                          << ", waited " << timing.wait_ms() << "ms)" << std::endl;
+            }
+            // Simulate additional processing
+            std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
+        };
+        if (rebalance) {
+            table.rebalance(partition, hold);
+        } else {
+            table.transfer(partition, from, to, amount, hold);
+        }
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " finished writing." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Print grants and waits per level and mode, and the scan consistency check
+    void print_lock_stats() {
+        table.print_report();
+    }
+};
+
+// Throughput of the scan/update mix on one table, in ops/s
+double hierarchy_throughput(Table& table, int threads, long long ops, int table_scans, int partition_scans,
+                            int rebalances, int updates) {
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::mt19937 gen(t + 1);
+            std::uniform_int_distribution<int> percent(0, 99);
+            std::uniform_int_distribution<int> partition_dist(0, table.partitions_in_table() - 1);
+            std::uniform_int_distribution<int> row_dist(0, table.rows_in_partition() - 1);
+            auto nothing = [] {};
+            auto ignore = [](long long) {};
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (long long i = 0; i < ops; i++) {
+                int roll = percent(gen);
+                int partition = partition_dist(gen);
+                if ((roll -= table_scans) < 0) {
+                    table.scan_table(ignore);
+                } else if ((roll -= partition_scans) < 0) {
+                    table.scan_partition(partition, ignore);
+                } else if ((roll -= rebalances) < 0) {
+                    table.rebalance(partition, nothing);
+                } else if ((roll -= updates) < 0) {
+                    table.transfer(partition, row_dist(gen), row_dist(gen), 1, nothing);
+                } else {
+                    table.read_row(partition, row_dist(gen), ignore);
+                }
+            }
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) worker.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * ops / seconds;
+}
+
+// WORKLOAD=hierarchy: the same mix of scans and point operations with multi-granularity
+// locking and with a single table lock
+int run_hierarchy_benchmark() {
+    const int partitions = env_or("HIER_PARTITIONS", 8);
+    const int rows = env_or("HIER_ROWS", 64);
+    const int threads = std::max(1LL, env_or("HIER_THREADS", 4));
+    const long long ops = std::max(1LL, env_or("HIER_OPS", 20000));
+    const int table_scans = env_or("HIER_TABLE_SCAN_PERCENT", 1);
+    const int partition_scans = env_or("HIER_PARTITION_SCAN_PERCENT", 4);
+    const int rebalances = env_or("HIER_SIX_PERCENT", 2);
+    const int updates = env_or("HIER_UPDATE_PERCENT", 30);
+    
+    std::cout << "\n----- HIERARCHY BENCHMARK -----" << std::endl;
+    std::cout << "Threads: " << threads << ", operations per thread: " << ops << ", mix: " << table_scans
+              << "% table scans, " << partition_scans << "% partition scans, " << rebalances << "% SIX rebalances, "
+              << updates << "% row updates, " << std::max(0, 100 - table_scans - partition_scans - rebalances - updates)
+              << "% row reads" << std::endl;
+    
+    Table fine(partitions, rows, false);
+    Table coarse(partitions, rows, true);
+    double fine_ops = hierarchy_throughput(fine, threads, ops, table_scans, partition_scans, rebalances, updates);
+    double coarse_ops = hierarchy_throughput(coarse, threads, ops, table_scans, partition_scans, rebalances, updates);
+    std::cout << "Multi-granularity: " << fine_ops << " ops/s" << std::endl;
+    std::cout << "Table lock only: " << coarse_ops << " ops/s" << std::endl;
+    std::cout << "Speedup: " << fine_ops / coarse_ops << "x" << std::endl;
+    fine.print_report();
+    coarse.print_report();
+    return 0;
+}
+
+// Statistics for the demonstration
+struct Statistics {
+    std::atomic<int> total_reads{0};
+    std::atomic<int> total_writes{0};
+    std::atomic<int> readers_waiting{0};
+    std::atomic<int> writers_waiting{0};
+    std::atomic<long long> reader_wait_time{0};
+    std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("Hierarchical", num_readers, num_writers, operations_per_thread) {}
+};
+
+int main() {
+    // Seed for random number generation
+    srand(static_cast<unsigned int>(time(nullptr)));
+    
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<IntentionLock>("Hierarchical", "IntentionLock",
+                                                   "one per table, partition and row; the wait queue allocates only while requests wait");
+    }
+    
+    // WORKLOAD=map benchmarks a striped hash map built on this lock (S and X modes) instead
+    if (map_workload_requested()) {
+        return run_map_benchmark<IntentionLock>("Hierarchical");
+    }
+    
+    // WORKLOAD=hierarchy compares multi-granularity locking with a single table lock
+    if (std::getenv("WORKLOAD") && std::string(std::getenv("WORKLOAD")) == "hierarchy") {
+        return run_hierarchy_benchmark();
+    }
+    
+    // Create shared resource
+    SharedResource resource;
+    
+    // Create threads for readers and writers
+    // Use environment variables if provided, otherwise use defaults
+    const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
+    const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
+    const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
+    
+    std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
+              << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
+    
+    std::vector<std::thread> threads;
+    
+    std::cout << "Starting readers-writers demonstration (HIERARCHICAL LOCKS) with "
+              << num_readers << " readers and " 
+              << num_writers << " writers." << std::endl;
+    
+    // Lambda to simulate reader behavior with random intervals
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to read
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.readers_waiting++;
+            OpTiming timing = resource.reader(id);
+            stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_reads++;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
+        }
+    };
+    
+    // Lambda to simulate writer behavior with random intervals
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to write
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.writers_waiting++;
+            OpTiming timing = resource.writer(id);
+            stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_writes++;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
+        }
+    };
+    
+    // Start reader threads
+    for (int i = 0; i < num_readers; i++) {
+        threads.emplace_back(reader_task, i + 1);
+    }
+    
+    // Start writer threads
+    for (int i = 0; i < num_writers; i++) {
+        threads.emplace_back(writer_task, i + 1);
+    }
+    
+    // Monitor thread for displaying statistics
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
+        int expected_operations = (num_readers + num_writers) * operations_per_thread;
+        int total_operations = 0;
+        
+        while (!run.done(total_operations, expected_operations)) {
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            total_operations = stats.total_reads + stats.total_writes;
+            
+            std::cout << "\n----- STATISTICS -----" << std::endl;
+            std::cout << "Completed reads: " << stats.total_reads << std::endl;
+            std::cout << "Completed writes: " << stats.total_writes << std::endl;
+            std::cout << "Readers waiting: " << stats.readers_waiting << std::endl;
+            std::cout << "Writers waiting: " << stats.writers_waiting << std::endl;
+            
+            // Calculate average wait times
+            float avg_reader_wait = stats.total_reads > 0 ? 
+                                     static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+            float avg_writer_wait = stats.total_writes > 0 ? 
+                                     static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+            
+            std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+            std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
+        }
+    });
+    
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
+    // Wait for all threads to complete
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    run.finish();
+    
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+    
+    std::cout << "\nDemonstration completed!" << std::endl;
+    std::cout << "Final statistics:" << std::endl;
+    std::cout << "Total reads: " << stats.total_reads << std::endl;
+    std::cout << "Total writes: " << stats.total_writes << std::endl;
+    
+    // Calculate final average wait times
+    float avg_reader_wait = stats.total_reads > 0 ? 
+                             static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+    float avg_writer_wait = stats.total_writes > 0 ? 
+                             static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+    
+    std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+    std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+    
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
+    return 0;
+}
@@ -0,0 +1,226 @@
+/**
+ * readers_writers_hierarchy.h - Multi-granularity (intention) locking for resource trees
+ *
+ * A hierarchy such as table -> partition -> row can be locked at any level. Locking a
+ * node in S or X implicitly locks its whole subtree; to keep that safe, every ancestor is
+ * first locked in an intention mode announcing what will happen further down:
+ *
+ *   IS   some descendant will be read
+ *   IX   some descendant will be written
+ *   S    the subtree is read
+ *   SIX  the subtree is read and some descendants will be written (S + IX)
+ *   X    the subtree is written
+ *
+ * Two holders are compatible according to the standard matrix (requested vs held):
+ *
+ *          IS  IX  S   SIX X
+ *   IS     y   y   y   y   -
+ *   IX     y   y   -   -   -
+ *   S      y   -   y   -   -
+ *   SIX    y   -   -   -   -
+ *   X      -   -   -   -   -
+ *
+ * IntentionLock is the per-node lock. It extends the reader/writer locks of this project
+ * (read_lock()/write_lock() are S and X) with the three intention modes. Requests that
+ * must wait queue in arrival order, and a newcomer also waits behind queued requests it
+ * is incompatible with, so a stream of IS readers cannot starve an X on the table.
+ *
+ * HierarchyGuard is the RAII helper: it locks the path from the root to a node (intention
+ * modes on the ancestors, the requested mode on the node) and releases it leaf first.
+ * lock_descendant() extends a guard further down, e.g. IX on a partition and then X on two
+ * of its rows. Nodes already covered by a held S, SIX or X are not locked again; a request
+ * the nearest held ancestor does not allow (X below IS or S, or a second mode on a node the
+ * guard already holds) throws std::logic_error instead of breaking exclusion. Callers
+ * that lock several nodes at one level must do so in a fixed order (e.g. ascending row),
+ * as with any set of locks.
+ */
+
+#ifndef READERS_WRITERS_HIERARCHY_H
+#define READERS_WRITERS_HIERARCHY_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "readers_writers_wait.h"
+
+enum class IntentionMode { IS, IX, S, SIX, X };
+
+constexpr int INTENTION_MODES = 5;
+
+inline const char* intention_mode_name(IntentionMode mode) {
+    static const char* const names[INTENTION_MODES] = {"IS", "IX", "S", "SIX", "X"};
+    return names[static_cast<int>(mode)];
+}
+
+inline bool intention_compatible(IntentionMode requested, IntentionMode held) {
+    static constexpr bool matrix[INTENTION_MODES][INTENTION_MODES] = {
+        //  IS     IX     S      SIX    X
+        {true,  true,  true,  true,  false},   // IS
+        {true,  true,  false, false, false},   // IX
+        {true,  false, true,  false, false},   // S
+        {true,  false, false, false, false},   // SIX
+        {false, false, false, false, false},   // X
+    };
+    return matrix[static_cast<int>(requested)][static_cast<int>(held)];
+}
+
+class IntentionLock {
+private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    WaitStrategy& wait;
+    std::deque<const IntentionMode*> queue;     // Waiting requests, oldest first
+    int granted[INTENTION_MODES] = {};          // Current holders per mode
+    long long grants[INTENTION_MODES] = {};
+    long long waits[INTENTION_MODES] = {};      // Grants that had to queue
+
+    // Compatible with every holder and with every request queued before it
+    bool grantable(const IntentionMode* request) const {
+        for (int held = 0; held < INTENTION_MODES; held++) {
+            if (granted[held] > 0 && !intention_compatible(*request, static_cast<IntentionMode>(held))) return false;
+        }
+        for (const IntentionMode* ahead : queue) {
+            if (ahead == request) break;
+            if (!intention_compatible(*request, *ahead)) return false;
+        }
+        return true;
+    }
+
+    static WaitStrategy& shared_wait() {
+        static WaitStrategy strategy;
+        return strategy;
+    }
+
+public:
+    // Nodes of one hierarchy normally share one wait strategy (and its statistics)
+    explicit IntentionLock(WaitStrategy& wait = shared_wait()) : wait(wait) {}
+
+    void lock(IntentionMode mode) {
+        std::unique_lock<std::mutex> guard(mtx);
+        int index = static_cast<int>(mode);
+        if (queue.empty() && grantable(&mode)) {
+            wait.record_uncontended();
+        } else {
+            queue.push_back(&mode);
+            if (!grantable(&mode)) waits[index]++;
+            wait.wait(guard, cv, [this, &mode] { return grantable(&mode); });
+            queue.erase(std::find(queue.begin(), queue.end(), &mode));
+        }
+        granted[index]++;
+        grants[index]++;
+    }
+
+    void unlock(IntentionMode mode) {
+        bool waiters;
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            granted[static_cast<int>(mode)]--;
+            waiters = !queue.empty();
+        }
+        if (waiters) cv.notify_all();
+    }
+
+    // The reader/writer interface of the other locks
+    void read_lock() { lock(IntentionMode::S); }
+    void read_unlock() { unlock(IntentionMode::S); }
+    void write_lock() { lock(IntentionMode::X); }
+    void write_unlock() { unlock(IntentionMode::X); }
+
+    // Add this lock's grant and wait counts per mode to the totals
+    void add_stats(long long (&grant_totals)[INTENTION_MODES], long long (&wait_totals)[INTENTION_MODES]) {
+        std::lock_guard<std::mutex> guard(mtx);
+        for (int mode = 0; mode < INTENTION_MODES; mode++) {
+            grant_totals[mode] += grants[mode];
+            wait_totals[mode] += waits[mode];
+        }
+    }
+};
+
+// One lockable node of a resource tree
+struct HierarchyNode {
+    IntentionLock lock;
+    HierarchyNode* parent = nullptr;
+
+    explicit HierarchyNode(WaitStrategy& wait) : lock(wait) {}
+};
+
+class HierarchyGuard {
+private:
+    std::vector<std::pair<HierarchyNode*, IntentionMode>> held;    // Root first
+
+    static IntentionMode intention_for(IntentionMode mode) {
+        return mode == IntentionMode::S || mode == IntentionMode::IS ? IntentionMode::IS : IntentionMode::IX;
+    }
+
+    // A held mode that already grants `requested` on the whole subtree
+    static bool covers(IntentionMode held_mode, IntentionMode requested) {
+        if (held_mode == IntentionMode::X) return true;
+        bool reading = requested == IntentionMode::S || requested == IntentionMode::IS;
+        return reading && (held_mode == IntentionMode::S || held_mode == IntentionMode::SIX);
+    }
+
+    // A held mode that allows locking descendants in `requested`: any mode for reads,
+    // IX, SIX or X for writes
+    static bool permits(IntentionMode held_mode, IntentionMode requested) {
+        if (requested == IntentionMode::S || requested == IntentionMode::IS) return true;
+        return held_mode == IntentionMode::IX || held_mode == IntentionMode::SIX || held_mode == IntentionMode::X;
+    }
+
+    const IntentionMode* held_mode(const HierarchyNode* node) const {
+        for (const auto& entry : held) {
+            if (entry.first == node) return &entry.second;
+        }
+        return nullptr;
+    }
+
+    // Lock `node` in `mode` and every not yet held ancestor in the matching intention mode.
+    // Throws std::logic_error, before locking anything, if the nearest held ancestor's mode
+    // does not allow it (e.g. X below an IS or S)
+    void lock_path(HierarchyNode& node, IntentionMode mode) {
+        std::vector<HierarchyNode*> path;   // Node first, up to the first held ancestor
+        for (HierarchyNode* current = &node; current != nullptr; current = current->parent) {
+            const IntentionMode* mode_held = held_mode(current);
+            if (mode_held != nullptr) {
+                if (covers(*mode_held, mode)) return;
+                if (current == &node || !permits(*mode_held, mode)) {
+                    throw std::logic_error(std::string("HierarchyGuard: cannot lock ") + intention_mode_name(mode) +
+                                           (current == &node ? " on a node already held in " : " below a node held in ") +
+                                           intention_mode_name(*mode_held));
+                }
+                break;
+            }
+            path.push_back(current);
+        }
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            IntentionMode step = *it == &node ? mode : intention_for(mode);
+            (*it)->lock.lock(step);
+            held.emplace_back(*it, step);
+        }
+    }
+
+public:
+    HierarchyGuard(HierarchyNode& node, IntentionMode mode) {
+        lock_path(node, mode);
+    }
+
+    HierarchyGuard(const HierarchyGuard&) = delete;
+    HierarchyGuard& operator=(const HierarchyGuard&) = delete;
+
+    ~HierarchyGuard() {
+        for (auto it = held.rbegin(); it != held.rend(); ++it) it->first->lock.unlock(it->second);
+    }
+
+    // Lock a node below one this guard holds; the nearest held ancestor must allow the mode
+    // (any mode for reads, IX, SIX or X for writes), otherwise std::logic_error is thrown
+    void lock_descendant(HierarchyNode& node, IntentionMode mode) {
+        lock_path(node, mode);
+    }
+};
+
+#endif // READERS_WRITERS_HIERARCHY_H
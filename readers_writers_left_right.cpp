@@ -0,0 +1,451 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <algorithm>
+#include <string>
+#include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
+
+// The shared data, with a COW_TABLE_SIZE-entry table (default 1024) standing in for a
+// configuration or routing table
+struct Snapshot {
+    long long version = 0;
+    int data = 0;
+    std::vector<int> table;
+    
+    size_t bytes() const {
+        return sizeof(Snapshot) + table.capacity() * sizeof(int);
+    }
+};
+
+// Left-Right Readers-Writers cell (Ramalhete & Correia)
+// Two copies of the data are kept. `left_right` says which copy readers use; writers only
+// ever modify the other one. A reader arrives at the read indicator selected by
+// `version_index`, reads the copy named by `left_right` and departs - a fixed number of
+// steps whatever the writers are doing, so reads are wait-free. A writer (one at a time):
+//   1. applies the mutation to the copy readers are not using
+//   2. flips `left_right`, so new readers move to the updated copy
+//   3. flips `version_index` and waits for both read indicators to drain in turn, which
+//      guarantees no reader is still on the old copy
+//   4. applies the same mutation to the old copy
+// Read indicators are per-thread counters on their own cache lines, so readers never write
+// a line another reader writes.
+class LeftRightCell {
+private:
+    // Per-thread read indicator: one arrival flag per version index
+    struct alignas(64) ReaderSlot {
+        std::atomic<int> arrived[2] = {{0}, {0}};
+        std::atomic<long long> reads{0};        // Written by the owning thread only
+        ReaderSlot* next = nullptr;
+    };
+    
+    Snapshot copies[2];
+    alignas(64) std::atomic<int> left_right{0};     // Copy readers use
+    alignas(64) std::atomic<int> version_index{0};  // Read indicator new readers arrive at
+    alignas(64) std::atomic<ReaderSlot*> slots{nullptr};
+    
+    std::mutex write_mtx;                       // Serialises writers; readers never take it
+    WaitStrategy wait;
+    long long writes = 0;                       // Statistics below are guarded by write_mtx
+    long long drain_waits = 0;                  // Toggles that found readers on the old side
+    double total_drain_ms = 0;
+    double max_drain_ms = 0;
+    
+    // The calling thread's read indicator, registered on first use
+    ReaderSlot* local_slot() {
+        thread_local const LeftRightCell* owner = nullptr;
+        thread_local ReaderSlot* slot = nullptr;
+        if (owner != this) {
+            slot = new ReaderSlot;
+            ReaderSlot* head = slots.load(std::memory_order_relaxed);
+            do {
+                slot->next = head;
+            } while (!slots.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+            owner = this;
+        }
+        return slot;
+    }
+    
+    bool drained(int index) const {
+        for (ReaderSlot* slot = slots.load(std::memory_order_acquire); slot != nullptr; slot = slot->next) {
+            if (slot->arrived[index].load(std::memory_order_seq_cst) != 0) return false;
+        }
+        return true;
+    }
+    
+    // Readers leave on their own and never signal, so the writer polls with growing pauses
+    void wait_until_drained(int index) {
+        for (int round = 0; !drained(index); round++) {
+            if (round < 64) {
+                cpu_pause();
+            } else if (round < 128) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(std::min(1000, 10 * (round - 127))));
+            }
+        }
+    }
+    
+public:
+    LeftRightCell() {
+        int table_size = std::getenv("COW_TABLE_SIZE") ? std::stoi(std::getenv("COW_TABLE_SIZE")) : 1024;
+        copies[0].table.assign(std::max(table_size, 1), 0);
+        copies[1] = copies[0];
+    }
+    
+    ~LeftRightCell() {
+        for (ReaderSlot* slot = slots.load(); slot != nullptr;) {
+            ReaderSlot* next = slot->next;
+            delete slot;
+            slot = next;
+        }
+    }
+    
+    // Run `read` on the copy no writer is touching; wait-free
+    template <typename Read>
+    void read(Read read) {
+        ReaderSlot* slot = local_slot();
+        int index = version_index.load(std::memory_order_seq_cst);
+        slot->arrived[index].store(1, std::memory_order_seq_cst);
+        read(static_cast<const Snapshot&>(copies[left_right.load(std::memory_order_seq_cst)]));
+        slot->arrived[index].store(0, std::memory_order_release);
+        slot->reads.store(slot->reads.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    
+    void write_lock() {
+        wait.acquire([this] { return write_mtx.try_lock(); }, [this] { write_mtx.lock(); });
+    }
+    
+    void write_unlock() {
+        write_mtx.unlock();
+    }
+    
+    // Apply `mutate` to both copies; write_lock() must be held. `mutate` runs twice and
+    // must produce the same result both times.
+    template <typename Mutate>
+    void modify(Mutate mutate) {
+        int active = left_right.load(std::memory_order_relaxed);
+        mutate(copies[1 - active]);
+        left_right.store(1 - active, std::memory_order_seq_cst);
+        
+        auto drain_start = std::chrono::steady_clock::now();
+        int previous = version_index.load(std::memory_order_relaxed);
+        wait_until_drained(1 - previous);
+        version_index.store(1 - previous, std::memory_order_seq_cst);
+        wait_until_drained(previous);
+        double drain_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - drain_start).count();
+        if (drain_ms >= 0.01) drain_waits++;
+        total_drain_ms += drain_ms;
+        max_drain_ms = std::max(max_drain_ms, drain_ms);
+        
+        mutate(copies[active]);
+        writes++;
+    }
+    
+    void print_wait_stats() {
+        std::lock_guard<std::mutex> guard(write_mtx);
+        long long reads = 0;
+        int reader_slots = 0;
+        for (ReaderSlot* slot = slots.load(); slot != nullptr; slot = slot->next) {
+            reads += slot->reads.load(std::memory_order_relaxed);
+            reader_slots++;
+        }
+        std::cout << "\n----- LEFT-RIGHT -----" << std::endl;
+        std::cout << "Wait-free reads: " << reads << " in " << reader_slots << " thread slots" << std::endl;
+        std::cout << "Writes applied to both copies: " << writes << std::endl;
+        std::cout << "Toggles that waited for readers to drain: " << drain_waits << std::endl;
+        std::cout << "Drain wait per write (avg/max): " << (writes > 0 ? total_drain_ms / writes : 0.0)
+                  << " / " << max_drain_ms << " ms" << std::endl;
+        std::cout << "Memory for the two copies: " << copies[0].bytes() + copies[1].bytes() << " bytes" << std::endl;
+        wait.print_report();
+    }
+};
+
+// Shared resource (two Left-Right copies of the data)
+class SharedResource {
+private:
+    LeftRightCell cell;
+    std::mutex print_mutex;  // For synchronized console output
+    
+public:
+    // Reader function: reads data from the copy writers are not touching
+    OpTiming reader(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " wants to read." << std::endl;
+        }
+        
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        cell.read([&](const Snapshot& snapshot) {
+            // Entering the read section never waits
+            timing.granted = std::chrono::steady_clock::now();
+            auto wait_time = timing.wait_ms();
+            
+            {
+                std::lock_guard<std::mutex> print_lock(print_mutex);
+                std::cout << "Reader " << id << " is reading data: " << snapshot.data
+                          << " (version " << snapshot.version << ", waited " << wait_time << "ms)" << std::endl;
+            }
+            
+            // Simulate reading process; writers will not modify this copy meanwhile
+            std::this_thread::sleep_for(std::chrono::milliseconds(100 + (rand() % 900)));
+        });
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " finished reading." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Writer function: applies a modification to both copies
+    OpTiming writer(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " wants to write." << std::endl;
+        }
+        
+        // Acquire write ownership (other writers only)
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        cell.write_lock();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        // Simulate writing process
+        int new_value = rand() % 1000;
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " is writing data: " << new_value
+                      << " (waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Simulate preparing the change
+        std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
+        
+        // Apply it to both copies; this waits for readers of the old copy to leave
+        cell.modify([new_value](Snapshot& snapshot) {
+            snapshot.version++;
+            snapshot.data = new_value;
+            snapshot.table[snapshot.version % snapshot.table.size()] = new_value;
+        });
+        cell.write_unlock();
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " finished writing." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Get the current data value
+    int get_data() {
+        int value = 0;
+        cell.read([&value](const Snapshot& snapshot) { value = snapshot.data; });
+        return value;
+    }
+    
+    // Print lock-internal statistics
+    void print_lock_stats() {
+        cell.print_wait_stats();
+    }
+};
+
+// Statistics for the demonstration
+struct Statistics {
+    std::atomic<int> total_reads{0};
+    std::atomic<int> total_writes{0};
+    std::atomic<int> readers_waiting{0};
+    std::atomic<int> writers_waiting{0};
+    std::atomic<long long> reader_wait_time{0};
+    std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("Left-Right", num_readers, num_writers, operations_per_thread) {}
+};
+
+int main() {
+    // Seed for random number generation
+    srand(static_cast<unsigned int>(time(nullptr)));
+    
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<LeftRightCell>("Left-Right", "LeftRightCell", "the tables of both copies, one 64-byte read indicator per thread");
+    }
+    
+    // Create shared resource
+    SharedResource resource;
+    
+    // Create threads for readers and writers
+    // Use environment variables if provided, otherwise use defaults
+    const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
+    const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
+    const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
+    
+    std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
+              << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
+    
+    std::vector<std::thread> threads;
+    
+    std::cout << "Starting readers-writers demonstration (LEFT-RIGHT) with "
+              << num_readers << " readers and " 
+              << num_writers << " writers." << std::endl;
+    
+    // Lambda to simulate reader behavior with random intervals
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to read
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.readers_waiting++;
+            OpTiming timing = resource.reader(id);
+            stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_reads++;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
+        }
+    };
+    
+    // Lambda to simulate writer behavior with random intervals
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to write
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.writers_waiting++;
+            OpTiming timing = resource.writer(id);
+            stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_writes++;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
+        }
+    };
+    
+    // Start reader threads
+    for (int i = 0; i < num_readers; i++) {
+        threads.emplace_back(reader_task, i + 1);
+    }
+    
+    // Start writer threads
+    for (int i = 0; i < num_writers; i++) {
+        threads.emplace_back(writer_task, i + 1);
+    }
+    
+    // Monitor thread for displaying statistics
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
+        int expected_operations = (num_readers + num_writers) * operations_per_thread;
+        int total_operations = 0;
+        
+        while (!run.done(total_operations, expected_operations)) {
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            total_operations = stats.total_reads + stats.total_writes;
+            
+            std::cout << "\n----- STATISTICS -----" << std::endl;
+            std::cout << "Completed reads: " << stats.total_reads << std::endl;
+            std::cout << "Completed writes: " << stats.total_writes << std::endl;
+            std::cout << "Readers waiting: " << stats.readers_waiting << std::endl;
+            std::cout << "Writers waiting: " << stats.writers_waiting << std::endl;
+            
+            // Calculate average wait times
+            float avg_reader_wait = stats.total_reads > 0 ? 
+                                     static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+            float avg_writer_wait = stats.total_writes > 0 ? 
+                                     static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+            
+            std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+            std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
+        }
+    });
+    
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
+    // Wait for all threads to complete
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    run.finish();
+    
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+    
+    std::cout << "\nDemonstration completed!" << std::endl;
+    std::cout << "Final statistics:" << std::endl;
+    std::cout << "Total reads: " << stats.total_reads << std::endl;
+    std::cout << "Total writes: " << stats.total_writes << std::endl;
+    
+    // Calculate final average wait times
+    float avg_reader_wait = stats.total_reads > 0 ? 
+                             static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+    float avg_writer_wait = stats.total_writes > 0 ? 
+                             static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+    
+    std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+    std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+    
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
+    return 0;
+}
@@ -0,0 +1,467 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_fifo.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
+
+enum class LockMode { SHARED, EXCLUSIVE };
+
+// Lock manager with a hashed lock table, in the style of a database lock table
+// Callers lock arbitrary 64-bit object ids in shared or exclusive mode. The table has a
+// fixed number of buckets (LOCK_TABLE_SIZE, default 1024), each with its own mutex and a
+// chain of lock heads. A lock head exists only while its id is held or waited for; it
+// carries the FIFO granting state of the fair lock (FifoGrantQueue), and waiters enqueue a
+// request that lives on their own stack. When the last holder leaves and nobody waits, the
+// head goes back to a shared pool and is reused for the next id that needs one.
+// Memory therefore grows with the number of ids locked at the same time, not the number
+// of ids that exist.
+class LockManager {
+private:
+    struct LockHead {
+        uint64_t id = 0;
+        FifoGrantQueue grants;
+        LockHead* next = nullptr;       // Bucket chain while in use, pool list otherwise
+    };
+    
+    struct alignas(64) Bucket {
+        std::mutex mtx;                 // Protects the chain and every head in it
+        LockHead* in_use = nullptr;
+    };
+    
+    size_t bucket_count;
+    std::unique_ptr<Bucket[]> table;
+    WaitStrategy wait;
+    
+    std::mutex pool_mtx;                        // Taken inside a bucket mutex, never the reverse
+    LockHead* pool = nullptr;
+    
+    std::atomic<long long> acquisitions{0};
+    std::atomic<long long> waited{0};           // Acquisitions that queued behind a holder
+    std::atomic<long long> heads_allocated{0};  // Pool growth
+    std::atomic<long long> heads_recycled{0};   // Heads reused from the pool
+    std::atomic<long long> heads_in_use{0};
+    std::atomic<long long> peak_heads_in_use{0};
+    
+    Bucket& bucket_for(uint64_t id) const {
+        uint64_t h = id * 0x9e3779b97f4a7c15ULL;
+        return table[(h ^ (h >> 32)) % bucket_count];
+    }
+    
+    static LockHead* find(Bucket& bucket, uint64_t id) {
+        for (LockHead* head = bucket.in_use; head != nullptr; head = head->next) {
+            if (head->id == id) return head;
+        }
+        return nullptr;
+    }
+    
+    // Lock head for `id`, attaching a recycled or new one if necessary; bucket mutex held
+    LockHead* attach(Bucket& bucket, uint64_t id) {
+        LockHead* head = find(bucket, id);
+        if (head != nullptr) return head;
+        
+        {
+            std::lock_guard<std::mutex> guard(pool_mtx);
+            head = pool;
+            if (head != nullptr) pool = head->next;
+        }
+        if (head != nullptr) {
+            heads_recycled++;
+        } else {
+            head = new LockHead;
+            heads_allocated++;
+        }
+        head->id = id;
+        head->next = bucket.in_use;
+        bucket.in_use = head;
+        
+        long long now = ++heads_in_use;
+        long long peak = peak_heads_in_use.load();
+        while (now > peak && !peak_heads_in_use.compare_exchange_weak(peak, now)) {}
+        return head;
+    }
+    
+    // Recycle an idle head; bucket mutex held
+    void detach(Bucket& bucket, LockHead* head) {
+        LockHead** link = &bucket.in_use;
+        while (*link != head) link = &(*link)->next;
+        *link = head->next;
+        heads_in_use--;
+        
+        std::lock_guard<std::mutex> guard(pool_mtx);
+        head->next = pool;
+        pool = head;
+    }
+    
+public:
+    LockManager()
+        : bucket_count(std::max(1, std::getenv("LOCK_TABLE_SIZE") ? std::stoi(std::getenv("LOCK_TABLE_SIZE")) : 1024)),
+          table(new Bucket[bucket_count]) {}
+    
+    ~LockManager() {
+        for (size_t i = 0; i < bucket_count; i++) {
+            for (LockHead* head = table[i].in_use; head != nullptr;) {
+                LockHead* next = head->next;
+                delete head;
+                head = next;
+            }
+        }
+        while (pool != nullptr) {
+            LockHead* next = pool->next;
+            delete pool;
+            pool = next;
+        }
+    }
+    
+    // Acquire `id` in `mode`; requests on one id are granted in FIFO order
+    void lock(uint64_t id, LockMode mode) {
+        Bucket& bucket = bucket_for(id);
+        std::unique_lock<std::mutex> lock(bucket.mtx);
+        LockHead* head = attach(bucket, id);
+        
+        FifoRequest request(mode == LockMode::SHARED ? RequestType::READ : RequestType::WRITE);
+        head->grants.enqueue(&request);
+        head->grants.process();
+        if (!request.granted) waited++;
+        wait.wait(lock, request.cv, [&request] { return request.granted; });
+        acquisitions++;
+    }
+    
+    void unlock(uint64_t id, LockMode mode) {
+        Bucket& bucket = bucket_for(id);
+        std::unique_lock<std::mutex> lock(bucket.mtx);
+        LockHead* head = find(bucket, id);
+        
+        if (mode == LockMode::SHARED) {
+            head->grants.active_readers--;
+        } else {
+            head->grants.writer_active = false;
+        }
+        head->grants.process();
+        if (head->grants.idle()) detach(bucket, head);
+    }
+    
+    void print_wait_stats(uint64_t id_count) const {
+        size_t table_bytes = bucket_count * sizeof(Bucket);
+        size_t head_bytes = heads_allocated * sizeof(LockHead);
+        std::cout << "\n----- LOCK MANAGER -----" << std::endl;
+        std::cout << "Lock table: " << bucket_count << " buckets (" << table_bytes << " bytes)" << std::endl;
+        std::cout << "Acquisitions: " << acquisitions << " (" << waited << " queued behind a holder)" << std::endl;
+        std::cout << "Lock heads in use (now/peak): " << heads_in_use << " / " << peak_heads_in_use << std::endl;
+        std::cout << "Lock heads allocated/recycled: " << heads_allocated << " / " << heads_recycled
+                  << " (" << head_bytes << " bytes)" << std::endl;
+        std::cout << "Lock memory for " << id_count << " ids: " << table_bytes + head_bytes
+                  << " bytes (one std::shared_mutex per id: " << id_count * sizeof(std::shared_mutex) << " bytes)" << std::endl;
+        wait.print_report();
+    }
+};
+
+// Shared resource (one integer per logical object)
+// Half of the operations (LOCK_HOT_PERCENT) go to the first LOCK_HOT_IDS ids (default 4) so
+// that some ids are contended; the rest are spread over all LOCK_IDS ids (default 1000000).
+class SharedResource {
+private:
+    LockManager locks;
+    uint64_t id_count;
+    uint64_t hot_ids;
+    int hot_percent;
+    std::vector<int> data;
+    std::mutex print_mutex;  // For synchronized console output
+    
+    static long long env_or(const char* name, long long fallback) {
+        return std::getenv(name) ? std::stoll(std::getenv(name)) : fallback;
+    }
+    
+    uint64_t pick_object() const {
+        if (rand() % 100 < hot_percent) return rand() % hot_ids;
+        return ((static_cast<uint64_t>(rand()) << 31) ^ rand()) % id_count;
+    }
+    
+public:
+    SharedResource()
+        : id_count(std::max(1LL, env_or("LOCK_IDS", 1000000))),
+          hot_ids(std::min<uint64_t>(id_count, std::max(1LL, env_or("LOCK_HOT_IDS", 4)))),
+          hot_percent(env_or("LOCK_HOT_PERCENT", 50)),
+          data(id_count, 0) {}
+    
+    // Reader function: reads one object under a shared lock on its id
+    OpTiming reader(int id) {
+        uint64_t object = pick_object();
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " wants to read object " << object << "." << std::endl;
+        }
+        
+        // Acquire a shared lock on the object
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        locks.lock(object, LockMode::SHARED);
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " is reading data: " << data[object]
+                      << " (object " << object << ", waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Simulate reading process
+        std::this_thread::sleep_for(std::chrono::milliseconds(100 + (rand() % 900)));
+        
+        // Release the shared lock
+        locks.unlock(object, LockMode::SHARED);
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " finished reading." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Writer function: modifies one object under an exclusive lock on its id
+    OpTiming writer(int id) {
+        uint64_t object = pick_object();
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " wants to write object " << object << "." << std::endl;
+        }
+        
+        // Acquire an exclusive lock on the object
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        locks.lock(object, LockMode::EXCLUSIVE);
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        // Simulate writing process
+        int new_value = rand() % 1000;
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " is writing data: " << new_value
+                      << " (object " << object << ", waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Modify the shared data
+        data[object] = new_value;
+        
+        // Simulate additional processing
+        std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
+        
+        // Release the exclusive lock
+        locks.unlock(object, LockMode::EXCLUSIVE);
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " finished writing." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Print lock-internal statistics
+    void print_lock_stats() const {
+        locks.print_wait_stats(id_count);
+    }
+};
+
+// Statistics for the demonstration
+struct Statistics {
+    std::atomic<int> total_reads{0};
+    std::atomic<int> total_writes{0};
+    std::atomic<int> readers_waiting{0};
+    std::atomic<int> writers_waiting{0};
+    std::atomic<long long> reader_wait_time{0};
+    std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("Lock Manager", num_readers, num_writers, operations_per_thread) {}
+};
+
+int main() {
+    // Seed for random number generation
+    srand(static_cast<unsigned int>(time(nullptr)));
+    
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<LockManager>("Lock Manager", "LockManager", "LOCK_TABLE_SIZE 64-byte buckets and one pooled lock head per id held or waited for");
+    }
+    
+    // Create shared resource
+    SharedResource resource;
+    
+    // Create threads for readers and writers
+    // Use environment variables if provided, otherwise use defaults
+    const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
+    const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
+    const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
+    
+    std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
+              << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
+    
+    std::vector<std::thread> threads;
+    
+    std::cout << "Starting readers-writers demonstration (LOCK MANAGER) with "
+              << num_readers << " readers and " 
+              << num_writers << " writers." << std::endl;
+    
+    // Lambda to simulate reader behavior with random intervals
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to read
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.readers_waiting++;
+            OpTiming timing = resource.reader(id);
+            stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_reads++;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
+        }
+    };
+    
+    // Lambda to simulate writer behavior with random intervals
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to write
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.writers_waiting++;
+            OpTiming timing = resource.writer(id);
+            stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_writes++;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
+        }
+    };
+    
+    // Start reader threads
+    for (int i = 0; i < num_readers; i++) {
+        threads.emplace_back(reader_task, i + 1);
+    }
+    
+    // Start writer threads
+    for (int i = 0; i < num_writers; i++) {
+        threads.emplace_back(writer_task, i + 1);
+    }
+    
+    // Monitor thread for displaying statistics
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
+        int expected_operations = (num_readers + num_writers) * operations_per_thread;
+        int total_operations = 0;
+        
+        while (!run.done(total_operations, expected_operations)) {
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            total_operations = stats.total_reads + stats.total_writes;
+            
+            std::cout << "\n----- STATISTICS -----" << std::endl;
+            std::cout << "Completed reads: " << stats.total_reads << std::endl;
+            std::cout << "Completed writes: " << stats.total_writes << std::endl;
+            std::cout << "Readers waiting: " << stats.readers_waiting << std::endl;
+            std::cout << "Writers waiting: " << stats.writers_waiting << std::endl;
+            
+            // Calculate average wait times
+            float avg_reader_wait = stats.total_reads > 0 ? 
+                                     static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+            float avg_writer_wait = stats.total_writes > 0 ? 
+                                     static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+            
+            std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+            std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
+        }
+    });
+    
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
+    // Wait for all threads to complete
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    run.finish();
+    
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+    
+    std::cout << "\nDemonstration completed!" << std::endl;
+    std::cout << "Final statistics:" << std::endl;
+    std::cout << "Total reads: " << stats.total_reads << std::endl;
+    std::cout << "Total writes: " << stats.total_writes << std::endl;
+    
+    // Calculate final average wait times
+    float avg_reader_wait = stats.total_reads > 0 ? 
+                             static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+    float avg_writer_wait = stats.total_writes > 0 ? 
+                             static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+    
+    std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+    std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+    
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
+    return 0;
+}
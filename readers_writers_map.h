@@ -0,0 +1,274 @@
+/**
+ * readers_writers_map.h - Striped concurrent hash map on top of any reader/writer lock
+ *
+ * StripedHashMap<Lock> splits its buckets into MAP_STRIPES stripes (default 16). Each
+ * stripe sits on its own cache lines with its own lock, so gets on different stripes never
+ * touch the same line and a put only excludes readers of one stripe. The lock type only
+ * needs read_lock()/read_unlock()/write_lock()/write_unlock(), so every implementation in
+ * this project can back it.
+ *
+ * Resizing is incremental and per stripe: when a stripe exceeds two entries per bucket it
+ * allocates a table twice as large, and every later put on that stripe moves a couple of
+ * buckets from the old table. Gets look in both tables until the move is complete, so no
+ * single operation pays for rehashing a whole stripe.
+ *
+ * With WORKLOAD=map a program runs run_map_benchmark() instead of its demonstration:
+ *
+ *   MAP_STRIPES=n        Stripes (default 16)
+ *   MAP_THREADS=n        Worker threads (default 4)
+ *   MAP_OPS=n            Operations per thread (default 200000)
+ *   MAP_KEYS=n           Key space; half of it is inserted up front (default 100000)
+ *   MAP_READ_PERCENT=n   Share of gets, the rest are puts (default 90)
+ */
+
+#ifndef READERS_WRITERS_MAP_H
+#define READERS_WRITERS_MAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template <typename Lock, typename Key = uint64_t, typename Value = int>
+class StripedHashMap {
+private:
+    using Bucket = std::vector<std::pair<Key, Value>>;
+
+    static constexpr size_t INITIAL_BUCKETS = 8;   // Per stripe; always a power of two
+    static constexpr size_t MAX_LOAD = 2;          // Entries per bucket before a stripe grows
+    static constexpr size_t MIGRATE_STEP = 2;      // Old buckets moved by each put
+
+    struct alignas(64) Stripe {
+        Lock lock;
+        std::vector<Bucket> table = std::vector<Bucket>(INITIAL_BUCKETS);
+        std::vector<Bucket> old_table;             // Non-empty while a resize is in progress
+        size_t migrated = 0;                       // Old buckets already moved
+        size_t size = 0;
+        long long resizes = 0;
+    };
+
+    size_t stripe_count;
+    std::unique_ptr<Stripe[]> stripes;
+
+    // Spread the key's hash; the low bits pick the stripe, the rest the bucket
+    static uint64_t mix(const Key& key) {
+        uint64_t h = std::hash<Key>{}(key) + 0x9e3779b97f4a7c15ULL;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+    Stripe& stripe_for(uint64_t hash) const {
+        return stripes[hash % stripe_count];
+    }
+
+    static size_t bucket_index(uint64_t hash, size_t buckets, size_t stripe_count) {
+        return (hash / stripe_count) & (buckets - 1);
+    }
+
+    static std::pair<Key, Value>* find(Bucket& bucket, const Key& key) {
+        for (auto& entry : bucket) {
+            if (entry.first == key) return &entry;
+        }
+        return nullptr;
+    }
+
+    // The old bucket holding `hash`, or nullptr if there is no resize or it has been moved
+    Bucket* unmigrated_bucket(Stripe& stripe, uint64_t hash) const {
+        if (stripe.old_table.empty()) return nullptr;
+        size_t index = bucket_index(hash, stripe.old_table.size(), stripe_count);
+        return index >= stripe.migrated ? &stripe.old_table[index] : nullptr;
+    }
+
+    // Move up to `count` old buckets into the new table; write lock held
+    void migrate(Stripe& stripe, size_t count) {
+        for (; count > 0 && stripe.migrated < stripe.old_table.size(); count--, stripe.migrated++) {
+            for (auto& entry : stripe.old_table[stripe.migrated]) {
+                uint64_t hash = mix(entry.first);
+                stripe.table[bucket_index(hash, stripe.table.size(), stripe_count)].push_back(std::move(entry));
+            }
+            Bucket().swap(stripe.old_table[stripe.migrated]);
+        }
+        if (!stripe.old_table.empty() && stripe.migrated == stripe.old_table.size()) {
+            std::vector<Bucket>().swap(stripe.old_table);
+            stripe.migrated = 0;
+        }
+    }
+
+    void start_resize(Stripe& stripe) {
+        migrate(stripe, stripe.old_table.size());   // Finish any earlier resize first
+        stripe.old_table = std::move(stripe.table);
+        stripe.table = std::vector<Bucket>(stripe.old_table.size() * 2);
+        stripe.migrated = 0;
+        stripe.resizes++;
+    }
+
+public:
+    explicit StripedHashMap(size_t stripe_count)
+        : stripe_count(std::max<size_t>(1, stripe_count)), stripes(new Stripe[this->stripe_count]) {}
+
+    bool get(const Key& key, Value& value) const {
+        uint64_t hash = mix(key);
+        Stripe& stripe = stripe_for(hash);
+        stripe.lock.read_lock();
+        auto* entry = find(stripe.table[bucket_index(hash, stripe.table.size(), stripe_count)], key);
+        if (entry == nullptr) {
+            Bucket* old = unmigrated_bucket(stripe, hash);
+            if (old != nullptr) entry = find(*old, key);
+        }
+        if (entry != nullptr) value = entry->second;
+        stripe.lock.read_unlock();
+        return entry != nullptr;
+    }
+
+    // Insert or overwrite; returns true if the key was new
+    bool put(const Key& key, const Value& value) {
+        uint64_t hash = mix(key);
+        Stripe& stripe = stripe_for(hash);
+        stripe.lock.write_lock();
+        migrate(stripe, MIGRATE_STEP);
+
+        Bucket* old = unmigrated_bucket(stripe, hash);
+        auto* entry = old != nullptr ? find(*old, key) : nullptr;
+        Bucket& bucket = stripe.table[bucket_index(hash, stripe.table.size(), stripe_count)];
+        if (entry == nullptr) entry = find(bucket, key);
+
+        bool inserted = entry == nullptr;
+        if (inserted) {
+            bucket.emplace_back(key, value);
+            stripe.size++;
+            if (stripe.size > MAX_LOAD * stripe.table.size()) start_resize(stripe);
+        } else {
+            entry->second = value;
+        }
+        stripe.lock.write_unlock();
+        return inserted;
+    }
+
+    bool erase(const Key& key) {
+        uint64_t hash = mix(key);
+        Stripe& stripe = stripe_for(hash);
+        stripe.lock.write_lock();
+        migrate(stripe, MIGRATE_STEP);
+
+        bool erased = false;
+        Bucket* old = unmigrated_bucket(stripe, hash);
+        for (Bucket* bucket : {old, &stripe.table[bucket_index(hash, stripe.table.size(), stripe_count)]}) {
+            if (bucket == nullptr || erased) continue;
+            auto it = std::find_if(bucket->begin(), bucket->end(), [&key](const auto& entry) { return entry.first == key; });
+            if (it != bucket->end()) {
+                *it = std::move(bucket->back());
+                bucket->pop_back();
+                stripe.size--;
+                erased = true;
+            }
+        }
+        stripe.lock.write_unlock();
+        return erased;
+    }
+
+    struct Summary {
+        size_t entries = 0;
+        size_t buckets = 0;
+        long long resizes = 0;
+        int resizing_stripes = 0;
+        size_t smallest_stripe = SIZE_MAX;
+        size_t largest_stripe = 0;
+    };
+
+    Summary summary() const {
+        Summary result;
+        for (size_t i = 0; i < stripe_count; i++) {
+            Stripe& stripe = stripes[i];
+            stripe.lock.read_lock();
+            result.entries += stripe.size;
+            result.buckets += stripe.table.size();
+            result.resizes += stripe.resizes;
+            result.resizing_stripes += stripe.old_table.empty() ? 0 : 1;
+            result.smallest_stripe = std::min(result.smallest_stripe, stripe.size);
+            result.largest_stripe = std::max(result.largest_stripe, stripe.size);
+            stripe.lock.read_unlock();
+        }
+        return result;
+    }
+};
+
+inline bool map_workload_requested() {
+    return std::getenv("WORKLOAD") && std::string(std::getenv("WORKLOAD")) == "map";
+}
+
+// Get/put throughput of a StripedHashMap backed by `Lock`; `policy` names the lock in the report
+template <typename Lock>
+int run_map_benchmark(const char* policy) {
+    auto env_or = [](const char* name, long long fallback) {
+        return std::getenv(name) ? std::stoll(std::getenv(name)) : fallback;
+    };
+    const size_t stripe_count = env_or("MAP_STRIPES", 16);
+    const int threads = std::max(1LL, env_or("MAP_THREADS", 4));
+    const long long ops_per_thread = env_or("MAP_OPS", 200000);
+    const uint64_t keys = std::max(1LL, env_or("MAP_KEYS", 100000));
+    const int read_percent = env_or("MAP_READ_PERCENT", 90);
+
+    StripedHashMap<Lock> map(stripe_count);
+    for (uint64_t key = 0; key < keys; key += 2) map.put(key, static_cast<int>(key));
+
+    std::atomic<bool> go{false};
+    std::atomic<long long> gets{0};
+    std::atomic<long long> hits{0};
+    std::atomic<long long> puts{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::mt19937_64 gen(t + 1);
+            std::uniform_int_distribution<uint64_t> key_dist(0, keys - 1);
+            std::uniform_int_distribution<int> op_dist(0, 99);
+            long long local_gets = 0, local_hits = 0, local_puts = 0;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (long long i = 0; i < ops_per_thread; i++) {
+                uint64_t key = key_dist(gen);
+                if (op_dist(gen) < read_percent) {
+                    int value;
+                    local_hits += map.get(key, value) ? 1 : 0;
+                    local_gets++;
+                } else {
+                    map.put(key, static_cast<int>(i));
+                    local_puts++;
+                }
+            }
+            gets += local_gets;
+            hits += local_hits;
+            puts += local_puts;
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) worker.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto summary = map.summary();
+    std::cout << "\n----- MAP BENCHMARK -----" << std::endl;
+    std::cout << "Lock policy: " << policy << std::endl;
+    std::cout << "Stripes: " << stripe_count << ", threads: " << threads << ", keys: " << keys
+              << ", gets: " << read_percent << "%" << std::endl;
+    std::cout << "Operations: " << gets + puts << " in " << seconds << " s (get hit rate "
+              << (gets > 0 ? 100.0 * hits / gets : 0.0) << "%)" << std::endl;
+    std::cout << "Map throughput: " << (gets + puts) / seconds << " ops/s (" << gets / seconds << " gets/s, "
+              << puts / seconds << " puts/s)" << std::endl;
+    std::cout << "Entries: " << summary.entries << " in " << summary.buckets << " buckets (stripe sizes "
+              << summary.smallest_stripe << " - " << summary.largest_stripe << ")" << std::endl;
+    std::cout << "Stripe resizes: " << summary.resizes << " (" << summary.resizing_stripes
+              << " still migrating)" << std::endl;
+    return 0;
+}
+
+#endif // READERS_WRITERS_MAP_H
@@ -7,41 +7,84 @@
 #include <random>
 #include <atomic>
 #include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_map.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
 
 // Implementation of Readers-Writers problem using a monitor approach
-// A monitor encapsulates shared data with procedures that provide synchronized access
+// A monitor encapsulates shared data with procedures that provide synchronized access.
+// Ownership is handed over directly: the releasing thread updates the monitor state on
+// behalf of the thread(s) it wakes, so a woken thread finds itself already admitted and
+// never has to compete for the lock again or loop on a predicate that turned false.
 class ReadersWriterMonitor {
 private:
     std::mutex monitor_mutex;           // The monitor lock
     std::condition_variable read_cv;    // Condition variable for readers
     std::condition_variable write_cv;   // Condition variable for writers
     
-    int reader_count = 0;               // Number of active readers
+    int reader_count = 0;               // Number of active readers (including admitted ones)
     bool writer_active = false;         // Flag to check if writer is active
     int waiting_readers = 0;            // Number of waiting readers
     int waiting_writers = 0;            // Number of waiting writers
     
+    // Handoff state
+    unsigned long read_generation = 0;  // Bumped each time the waiting readers are admitted
+    int writer_tickets = 0;             // Write ownership handed to a still-sleeping writer
+    long long writer_handoffs = 0;      // Diagnostics: direct handoffs to a writer
+    long long reader_batches = 0;       // Diagnostics: batches of readers admitted at once
+    
+    WaitStrategy wait;                  // Spin-then-park policy for blocked threads
+    LockStateSnapshot snapshot;         // Lock-free copy of the state for get_state()
+    
+    // Publish the current state for get_state(); called with monitor_mutex held
+    void publish_state() {
+        LockState state;
+        state.active_readers = reader_count;
+        state.writer_active = writer_active;
+        state.waiting_readers = waiting_readers;
+        state.waiting_writers = waiting_writers;
+        state.queue_depth = waiting_readers + waiting_writers;
+        snapshot.publish(state);
+    }
+    
+    // Pass write ownership to one waiting writer; writer_active stays set
+    void handoff_to_writer() {
+        waiting_writers--;
+        writer_tickets++;
+        writer_handoffs++;
+        write_cv.notify_one();
+    }
+    
+    // Admit every waiting reader as one batch
+    void admit_readers() {
+        reader_count += waiting_readers;
+        waiting_readers = 0;
+        read_generation++;
+        reader_batches++;
+        read_cv.notify_all();
+    }
+    
 public:
     // Reader tries to enter the monitor
     void start_read() {
         std::unique_lock<std::mutex> lock(monitor_mutex);
         
-        // Increment waiting readers count
-        waiting_readers++;
-        
-        // Wait if there's an active writer or waiting writers (writer preference)
-        while (writer_active || waiting_writers > 0) {
-            read_cv.wait(lock);
+        // Enter directly if there's no active writer and no waiting writers (writer preference)
+        if (!writer_active && waiting_writers == 0) {
+            reader_count++;
+            publish_state();
+            wait.record_uncontended();
+            return;
         }
         
-        // Decrement waiting readers and increment active readers
-        waiting_readers--;
-        reader_count++;
-        
-        // Signal other waiting readers that they can proceed too
-        read_cv.notify_one();
-        
-        lock.unlock();
+        // Otherwise wait until a writer admits this reader's batch; the writer has
+        // already counted us in reader_count
+        waiting_readers++;
+        publish_state();
+        unsigned long generation = read_generation;
+        wait.wait(lock, read_cv, [this, generation] { return read_generation != generation; });
     }
     
     // Reader finishes reading
@@ -51,63 +94,79 @@ public:
         // Decrement active readers count
         reader_count--;
         
-        // If this was the last reader and writers are waiting, signal a writer
+        // If this was the last reader and writers are waiting, hand the monitor to a writer
         if (reader_count == 0 && waiting_writers > 0) {
-            write_cv.notify_one();
+            writer_active = true;
+            handoff_to_writer();
         }
-        
-        lock.unlock();
+        publish_state();
     }
     
     // Writer tries to enter the monitor
     void start_write() {
         std::unique_lock<std::mutex> lock(monitor_mutex);
         
-        // Increment waiting writers count
-        waiting_writers++;
-        
-        // Wait until there are no active readers and no active writers
-        while (reader_count > 0 || writer_active) {
-            write_cv.wait(lock);
+        // Enter directly if there are no active readers and no active writer
+        if (reader_count == 0 && !writer_active) {
+            writer_active = true;
+            publish_state();
+            wait.record_uncontended();
+            return;
         }
         
-        // Decrement waiting writers count and mark writer as active
-        waiting_writers--;
-        writer_active = true;
-        
-        lock.unlock();
+        // Otherwise wait for a releasing thread to hand over ownership
+        waiting_writers++;
+        publish_state();
+        wait.wait(lock, write_cv, [this] { return writer_tickets > 0; });
+        writer_tickets--;
     }
     
     // Writer finishes writing
     void end_write() {
         std::unique_lock<std::mutex> lock(monitor_mutex);
         
-        // Mark writer as inactive
-        writer_active = false;
-        
-        // If there are waiting writers, signal one writer
+        // If there are waiting writers, hand ownership to one of them
         if (waiting_writers > 0) {
-            write_cv.notify_one();
-        } 
-        // Otherwise signal all waiting readers
-        else if (waiting_readers > 0) {
-            read_cv.notify_all();
+            handoff_to_writer();
+            publish_state();
+            return;
         }
         
-        lock.unlock();
+        // Otherwise admit all waiting readers at once
+        writer_active = false;
+        if (waiting_readers > 0) {
+            admit_readers();
+        }
+        publish_state();
     }
     
-    // Get monitor state for diagnostics
+    // Get monitor state for diagnostics; reads the published snapshot, so polling
+    // never contends with the monitor lock
     void get_state(int& readers, int& writers, int& w_readers, int& w_writers) const {
-        // Use const_cast since this is just for diagnostics and doesn't modify the state
-        std::lock_guard<std::mutex> lock(*const_cast<std::mutex*>(&monitor_mutex));
-        readers = reader_count;
-        writers = writer_active ? 1 : 0;
-        w_readers = waiting_readers;
-        w_writers = waiting_writers;
+        LockState state = snapshot.load();
+        readers = state.active_readers;
+        writers = state.writer_active ? 1 : 0;
+        w_readers = state.waiting_readers;
+        w_writers = state.waiting_writers;
+    }
+    
+    // Print how the waits were resolved
+    void print_wait_stats() const {
+        std::cout << "\n----- MONITOR HANDOFFS -----" << std::endl;
+        std::cout << "Direct handoffs to writers: " << writer_handoffs << std::endl;
+        std::cout << "Reader batches admitted: " << reader_batches << std::endl;
+        wait.print_report();
     }
 };
 
+// The read_lock()/write_lock() interface expected by readers_writers_map.h
+struct MonitorLockAdapter : ReadersWriterMonitor {
+    void read_lock() { start_read(); }
+    void read_unlock() { end_read(); }
+    void write_lock() { start_write(); }
+    void write_unlock() { end_write(); }
+};
+
 // Shared resource (simulated as an integer)
 class SharedResource {
 private:
@@ -117,17 +176,18 @@ private:
     
 public:
     // Reader function: reads data from the shared resource
-    int reader(int id) {
+    OpTiming reader(int id) {
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Reader " << id << " wants to read." << std::endl;
         }
         
         // Enter monitor to read
-        auto start_time = std::chrono::steady_clock::now();
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         monitor.start_read();
-        auto end_time = std::chrono::steady_clock::now();
-        auto wait_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
         
         // Critical section - reading data
         {
@@ -141,27 +201,29 @@ public:
         
         // Exit monitor
         monitor.end_read();
+        timing.released = std::chrono::steady_clock::now();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Reader " << id << " finished reading." << std::endl;
         }
         
-        return wait_time;
+        return timing;
     }
     
     // Writer function: modifies the shared resource
-    int writer(int id) {
+    OpTiming writer(int id) {
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Writer " << id << " wants to write." << std::endl;
         }
         
         // Enter monitor to write
-        auto start_time = std::chrono::steady_clock::now();
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         monitor.start_write();
-        auto end_time = std::chrono::steady_clock::now();
-        auto wait_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
         
         // Generate new data value
         int new_value = rand() % 1000;
@@ -181,19 +243,25 @@ public:
         
         // Exit monitor
         monitor.end_write();
+        timing.released = std::chrono::steady_clock::now();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Writer " << id << " finished writing." << std::endl;
         }
         
-        return wait_time;
+        return timing;
     }
     
     // Get monitor state
     void get_monitor_state(int& readers, int& writers, int& w_readers, int& w_writers) const {
         monitor.get_state(readers, writers, w_readers, w_writers);
     }
+    
+    // Print lock-internal statistics
+    void print_lock_stats() const {
+        monitor.print_wait_stats();
+    }
 };
 
 // Statistics for the demonstration
@@ -204,24 +272,46 @@ struct Statistics {
     std::atomic<int> writers_waiting{0};
     std::atomic<long long> reader_wait_time{0};
     std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("Monitor-based", num_readers, num_writers, operations_per_thread) {}
 };
 
 int main() {
     // Seed for random number generation
     srand(static_cast<unsigned int>(time(nullptr)));
     
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<ReadersWriterMonitor>("Monitor-based", "ReadersWriterMonitor");
+    }
+    
+    // WORKLOAD=map benchmarks a striped hash map built on this lock instead
+    if (map_workload_requested()) {
+        return run_map_benchmark<MonitorLockAdapter>("Monitor-based");
+    }
+    
     // Create shared resource
     SharedResource resource;
-    Statistics stats;
     
     // Create threads for readers and writers
     // Use environment variables if provided, otherwise use defaults
     const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
     const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
     const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
     
     std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
               << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
     
     std::vector<std::thread> threads;
     
@@ -230,38 +320,62 @@ int main() {
               << num_writers << " writers." << std::endl;
     
     // Lambda to simulate reader behavior with random intervals
-    auto reader_task = [&resource, &stats, operations_per_thread](int id) {
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
         
-        for (int i = 0; i < operations_per_thread; i++) {
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
             // Random delay before attempting to read
             std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
             
             stats.readers_waiting++;
-            long long wait_time = resource.reader(id);
+            OpTiming timing = resource.reader(id);
             stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
             stats.total_reads++;
-            stats.reader_wait_time += wait_time;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
         }
     };
     
     // Lambda to simulate writer behavior with random intervals
-    auto writer_task = [&resource, &stats, operations_per_thread](int id) {
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
         
-        for (int i = 0; i < operations_per_thread; i++) {
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
             // Random delay before attempting to write
             std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
             
             stats.writers_waiting++;
-            long long wait_time = resource.writer(id);
+            OpTiming timing = resource.writer(id);
             stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
             stats.total_writes++;
-            stats.writer_wait_time += wait_time;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
         }
     };
     
@@ -276,11 +390,11 @@ int main() {
     }
     
     // Monitor thread for displaying statistics
-    std::thread monitor([&resource, &stats, num_readers, num_writers, operations_per_thread]() {
+    std::thread monitor([&resource, &stats, &run, num_readers, num_writers, operations_per_thread]() {
         int expected_operations = (num_readers + num_writers) * operations_per_thread;
         int total_operations = 0;
         
-        while (total_operations < expected_operations) {
+        while (!run.done(total_operations, expected_operations)) {
             std::this_thread::sleep_for(std::chrono::seconds(2));
             total_operations = stats.total_reads + stats.total_writes;
             
@@ -306,16 +420,20 @@ int main() {
             
             std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
             std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
-            std::cout << "Progress: " << (total_operations * 100) / expected_operations << "%" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
         }
     });
     
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
     // Wait for all threads to complete
     for (auto& thread : threads) {
         if (thread.joinable()) {
             thread.join();
         }
     }
+    run.finish();
     
     if (monitor.joinable()) {
         monitor.join();
@@ -335,5 +453,11 @@ int main() {
     std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
     std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
     
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
     return 0;
 }
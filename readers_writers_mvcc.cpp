@@ -0,0 +1,584 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <map>
+#include <random>
+#include <atomic>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <cstdint>
+#include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
+
+// Multi-version Readers-Writers store
+// MVCC_KEYS integer keys (default 8), each with a chain of versions, newest first. A writer
+// commits any number of keys at once under a new timestamp: it links the new versions at
+// the heads of their chains and then advances the commit clock, which makes them visible
+// together. A reader pins a snapshot - the commit clock at that moment - in its own
+// per-thread slot and reads any keys lock-free by walking each chain to the newest version
+// not newer than the snapshot, so multi-key reads are consistent without any read lock.
+// After each commit the writer garbage-collects: for every key it keeps the newest version
+// visible to the oldest pinned snapshot and frees everything older. Readers never walk past
+// that version, so the freed ones are unreachable.
+class MvccStore {
+private:
+    struct Version {
+        uint64_t timestamp;
+        int value;
+        std::atomic<Version*> older;
+    };
+    
+    static constexpr uint64_t UNPINNED = std::numeric_limits<uint64_t>::max();
+    
+    // Per-thread snapshot pin
+    struct alignas(64) PinSlot {
+        std::atomic<uint64_t> pinned{UNPINNED};
+        PinSlot* next = nullptr;
+    };
+    
+    std::vector<std::atomic<Version*>> heads;
+    alignas(64) std::atomic<uint64_t> commit_clock{0};
+    alignas(64) std::atomic<PinSlot*> slots{nullptr};
+    
+    std::mutex write_mtx;                       // Serialises commits and garbage collection
+    WaitStrategy wait;
+    std::atomic<long long> snapshots{0};
+    long long commits = 0;                      // Statistics below are guarded by write_mtx
+    long long versions_created = 0;
+    long long versions_reclaimed = 0;
+    long long live_versions = 0;
+    long long peak_live_versions = 0;
+    uint64_t max_gc_lag = 0;                    // Commits between the clock and the oldest pin
+    
+    PinSlot* local_slot() {
+        thread_local const MvccStore* owner = nullptr;
+        thread_local PinSlot* slot = nullptr;
+        if (owner != this) {
+            slot = new PinSlot;
+            PinSlot* head = slots.load(std::memory_order_relaxed);
+            do {
+                slot->next = head;
+            } while (!slots.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+            owner = this;
+        }
+        return slot;
+    }
+    
+    // Oldest timestamp a pinned snapshot may still read; write_mtx must be held
+    uint64_t oldest_pinned() const {
+        uint64_t oldest = commit_clock.load(std::memory_order_seq_cst);
+        for (PinSlot* slot = slots.load(std::memory_order_acquire); slot != nullptr; slot = slot->next) {
+            oldest = std::min(oldest, slot->pinned.load(std::memory_order_seq_cst));
+        }
+        return oldest;
+    }
+    
+    // Free versions no snapshot can reach; write_mtx must be held
+    void collect_garbage() {
+        uint64_t horizon = oldest_pinned();
+        max_gc_lag = std::max(max_gc_lag, commit_clock.load(std::memory_order_relaxed) - horizon);
+        for (auto& head : heads) {
+            Version* keep = head.load(std::memory_order_relaxed);
+            while (keep->timestamp > horizon) keep = keep->older.load(std::memory_order_relaxed);
+            Version* old = keep->older.exchange(nullptr, std::memory_order_relaxed);
+            while (old != nullptr) {
+                Version* next = old->older.load(std::memory_order_relaxed);
+                delete old;
+                versions_reclaimed++;
+                live_versions--;
+                old = next;
+            }
+        }
+    }
+    
+public:
+    // A pinned, consistent view of every key; unpins on destruction. One per thread at a time.
+    class Snapshot {
+    private:
+        const MvccStore* store;
+        PinSlot* slot;
+        uint64_t ts;
+        
+    public:
+        Snapshot(const MvccStore* store, PinSlot* slot, uint64_t ts) : store(store), slot(slot), ts(ts) {}
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        Snapshot(Snapshot&& other) : store(other.store), slot(other.slot), ts(other.ts) {
+            other.slot = nullptr;
+        }
+        
+        ~Snapshot() {
+            if (slot != nullptr) slot->pinned.store(UNPINNED, std::memory_order_release);
+        }
+        
+        uint64_t timestamp() const {
+            return ts;
+        }
+        
+        // Value of `key` as of this snapshot; lock-free
+        int read(int key) const {
+            return visible(key)->value;
+        }
+        
+        // Commit timestamp of the version of `key` this snapshot sees
+        uint64_t version_timestamp(int key) const {
+            return visible(key)->timestamp;
+        }
+        
+    private:
+        Version* visible(int key) const {
+            Version* version = store->heads[key].load(std::memory_order_acquire);
+            while (version->timestamp > ts) version = version->older.load(std::memory_order_acquire);
+            return version;
+        }
+    };
+    
+    // Client session: every snapshot it takes includes the session's own earlier commits
+    class Session {
+    private:
+        MvccStore& store;
+        uint64_t last_commit = 0;
+        long long own_writes_checked = 0;
+        
+    public:
+        explicit Session(MvccStore& store) : store(store) {}
+        
+        Snapshot snapshot() {
+            return store.pin(last_commit);
+        }
+        
+        // Commit `updates` (key -> value) atomically; write ownership must be held
+        uint64_t commit(const std::map<int, int>& updates) {
+            last_commit = store.commit(updates);
+            return last_commit;
+        }
+        
+        // Check through a new snapshot that our last commit, which wrote `key`, is visible:
+        // the snapshot and the version of `key` it sees must be at least that commit. Values
+        // are not compared, since another writer may commit the same key in the meantime
+        bool check_own_write(int key) {
+            own_writes_checked++;
+            Snapshot view = snapshot();
+            return view.timestamp() >= last_commit && view.version_timestamp(key) >= last_commit;
+        }
+        
+        long long checks() const {
+            return own_writes_checked;
+        }
+    };
+    
+    explicit MvccStore(int keys, int initial_value) : heads(keys) {
+        for (auto& head : heads) {
+            head.store(new Version{0, initial_value, {nullptr}});
+        }
+        versions_created = live_versions = peak_live_versions = keys;
+    }
+    
+    ~MvccStore() {
+        for (auto& head : heads) {
+            for (Version* version = head.load(); version != nullptr;) {
+                Version* older = version->older.load();
+                delete version;
+                version = older;
+            }
+        }
+        for (PinSlot* slot = slots.load(); slot != nullptr;) {
+            PinSlot* next = slot->next;
+            delete slot;
+            slot = next;
+        }
+    }
+    
+    int key_count() const {
+        return heads.size();
+    }
+    
+    // Pin the latest snapshot, waiting (briefly) until it includes timestamp `at_least`
+    Snapshot pin(uint64_t at_least = 0) {
+        PinSlot* slot = local_slot();
+        uint64_t ts = commit_clock.load(std::memory_order_seq_cst);
+        for (;;) {
+            while (ts < at_least) {
+                cpu_pause();
+                ts = commit_clock.load(std::memory_order_seq_cst);
+            }
+            slot->pinned.store(ts, std::memory_order_seq_cst);
+            // If the clock moved, a collector may have missed our pin; pin the newer snapshot
+            uint64_t now = commit_clock.load(std::memory_order_seq_cst);
+            if (now == ts) break;
+            ts = now;
+        }
+        snapshots.fetch_add(1, std::memory_order_relaxed);
+        return Snapshot(this, slot, ts);
+    }
+    
+    void write_lock() {
+        wait.acquire([this] { return write_mtx.try_lock(); }, [this] { write_mtx.lock(); });
+    }
+    
+    void write_unlock() {
+        write_mtx.unlock();
+    }
+    
+    // Install new versions of `updates` under one timestamp and collect garbage;
+    // write_lock() must be held
+    uint64_t commit(const std::map<int, int>& updates) {
+        uint64_t ts = commit_clock.load(std::memory_order_relaxed) + 1;
+        for (const auto& update : updates) {
+            auto& head = heads[update.first];
+            head.store(new Version{ts, update.second, {head.load(std::memory_order_relaxed)}}, std::memory_order_release);
+        }
+        commit_clock.store(ts, std::memory_order_seq_cst);
+        commits++;
+        versions_created += updates.size();
+        live_versions += updates.size();
+        peak_live_versions = std::max(peak_live_versions, live_versions);
+        collect_garbage();
+        return ts;
+    }
+    
+    void print_report() {
+        std::lock_guard<std::mutex> guard(write_mtx);
+        std::cout << "\n----- MVCC STORE -----" << std::endl;
+        std::cout << "Keys: " << heads.size() << ", commits: " << commits << " (clock " << commit_clock << ")" << std::endl;
+        std::cout << "Snapshots pinned: " << snapshots << std::endl;
+        std::cout << "Versions created/reclaimed: " << versions_created << " / " << versions_reclaimed << std::endl;
+        std::cout << "Live versions (now/peak): " << live_versions << " / " << peak_live_versions << std::endl;
+        std::cout << "Largest GC lag behind the clock: " << max_gc_lag << " commits" << std::endl;
+    }
+    
+    void print_wait_stats() const {
+        wait.print_report();
+    }
+};
+
+// Shared resource (a small versioned key-value store)
+// Writers move an amount between two keys in one commit, so the sum of all keys never
+// changes; readers read every key from one snapshot and check that sum.
+class SharedResource {
+private:
+    static constexpr int INITIAL_VALUE = 100;
+    
+    MvccStore store;
+    std::mutex print_mutex;  // For synchronized console output
+    std::mutex session_mutex;
+    std::map<int, MvccStore::Session> writer_sessions;   // Writer id -> session; nodes never move
+    std::atomic<int> inconsistent_snapshots{0};
+    std::atomic<int> missed_own_writes{0};
+    
+    static int key_count() {
+        return std::max(2, std::getenv("MVCC_KEYS") ? std::stoi(std::getenv("MVCC_KEYS")) : 8);
+    }
+    
+    MvccStore::Session& session_for(int writer_id) {
+        std::lock_guard<std::mutex> guard(session_mutex);
+        return writer_sessions.emplace(writer_id, MvccStore::Session(store)).first->second;
+    }
+    
+public:
+    SharedResource() : store(key_count(), INITIAL_VALUE) {}
+    
+    // Reader function: reads every key from one pinned snapshot
+    OpTiming reader(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " wants to read." << std::endl;
+        }
+        
+        // Pin a snapshot; this never waits for a writer
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        {
+            MvccStore::Snapshot snapshot = store.pin();
+            timing.granted = std::chrono::steady_clock::now();
+            auto wait_time = timing.wait_ms();
+            
+            int sum = 0;
+            for (int key = 0; key < store.key_count(); key++) sum += snapshot.read(key);
+            if (sum != INITIAL_VALUE * store.key_count()) inconsistent_snapshots++;
+            
+            {
+                std::lock_guard<std::mutex> print_lock(print_mutex);
+                std::cout << "Reader " << id << " is reading data: " << snapshot.read(0)
+                          << " (snapshot " << snapshot.timestamp() << ", sum " << sum
+                          << ", waited " << wait_time << "ms)" << std::endl;
+            }
+            
+            // Simulate reading process; the snapshot keeps its versions alive meanwhile
+            std::this_thread::sleep_for(std::chrono::milliseconds(100 + (rand() % 900)));
+        }
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " finished reading." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Writer function: moves an amount between two keys in one commit
+    OpTiming writer(int id) {
+        MvccStore::Session& session = session_for(id);
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " wants to write." << std::endl;
+        }
+        
+        // Acquire write ownership (other writers only)
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        store.write_lock();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        // Simulate writing process
+        int from = rand() % store.key_count();
+        int to = (from + 1 + rand() % (store.key_count() - 1)) % store.key_count();
+        std::map<int, int> updates;
+        int amount = 0;
+        {
+            // No other commit can happen while we hold write ownership, so this is current
+            MvccStore::Snapshot current = session.snapshot();
+            int available = current.read(from);
+            amount = available > 0 ? 1 + rand() % available : 0;
+            updates = {{from, available - amount}, {to, current.read(to) + amount}};
+        }
+        int new_value = updates[to];
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " is writing data: " << new_value
+                      << " (key " << to << ", moved " << amount << " from key " << from
+                      << ", waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Simulate additional processing
+        std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
+        
+        // Commit both keys at once
+        session.commit(updates);
+        store.write_unlock();
+        timing.released = std::chrono::steady_clock::now();
+        
+        // Read-your-writes: a session snapshot always includes the session's last commit
+        if (!session.check_own_write(to)) missed_own_writes++;
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " finished writing." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Get the current value of key 0
+    int get_data() {
+        return store.pin().read(0);
+    }
+    
+    // Print lock-internal statistics
+    void print_lock_stats() {
+        long long checks = 0;
+        {
+            std::lock_guard<std::mutex> guard(session_mutex);
+            for (const auto& entry : writer_sessions) checks += entry.second.checks();
+        }
+        store.print_report();
+        std::cout << "Inconsistent snapshots (sum changed): " << inconsistent_snapshots << std::endl;
+        std::cout << "Read-your-writes checks failed: " << missed_own_writes << " of " << checks << std::endl;
+        store.print_wait_stats();
+    }
+};
+
+// Statistics for the demonstration
+struct Statistics {
+    std::atomic<int> total_reads{0};
+    std::atomic<int> total_writes{0};
+    std::atomic<int> readers_waiting{0};
+    std::atomic<int> writers_waiting{0};
+    std::atomic<long long> reader_wait_time{0};
+    std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("MVCC", num_readers, num_writers, operations_per_thread) {}
+};
+
+int main() {
+    // Seed for random number generation
+    srand(static_cast<unsigned int>(time(nullptr)));
+    
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<MvccStore>("MVCC", "MvccStore", "the version chains of every key, one 64-byte pin slot per thread");
+    }
+    
+    // Create shared resource
+    SharedResource resource;
+    
+    // Create threads for readers and writers
+    // Use environment variables if provided, otherwise use defaults
+    const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
+    const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
+    const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
+    
+    std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
+              << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
+    
+    std::vector<std::thread> threads;
+    
+    std::cout << "Starting readers-writers demonstration (MVCC SNAPSHOTS) with "
+              << num_readers << " readers and " 
+              << num_writers << " writers." << std::endl;
+    
+    // Lambda to simulate reader behavior with random intervals
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to read
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.readers_waiting++;
+            OpTiming timing = resource.reader(id);
+            stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_reads++;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
+        }
+    };
+    
+    // Lambda to simulate writer behavior with random intervals
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to write
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.writers_waiting++;
+            OpTiming timing = resource.writer(id);
+            stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_writes++;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
+        }
+    };
+    
+    // Start reader threads
+    for (int i = 0; i < num_readers; i++) {
+        threads.emplace_back(reader_task, i + 1);
+    }
+    
+    // Start writer threads
+    for (int i = 0; i < num_writers; i++) {
+        threads.emplace_back(writer_task, i + 1);
+    }
+    
+    // Monitor thread for displaying statistics
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
+        int expected_operations = (num_readers + num_writers) * operations_per_thread;
+        int total_operations = 0;
+        
+        while (!run.done(total_operations, expected_operations)) {
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            total_operations = stats.total_reads + stats.total_writes;
+            
+            std::cout << "\n----- STATISTICS -----" << std::endl;
+            std::cout << "Completed reads: " << stats.total_reads << std::endl;
+            std::cout << "Completed writes: " << stats.total_writes << std::endl;
+            std::cout << "Readers waiting: " << stats.readers_waiting << std::endl;
+            std::cout << "Writers waiting: " << stats.writers_waiting << std::endl;
+            
+            // Calculate average wait times
+            float avg_reader_wait = stats.total_reads > 0 ? 
+                                     static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+            float avg_writer_wait = stats.total_writes > 0 ? 
+                                     static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+            
+            std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+            std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
+        }
+    });
+    
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
+    // Wait for all threads to complete
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    run.finish();
+    
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+    
+    std::cout << "\nDemonstration completed!" << std::endl;
+    std::cout << "Final statistics:" << std::endl;
+    std::cout << "Total reads: " << stats.total_reads << std::endl;
+    std::cout << "Total writes: " << stats.total_writes << std::endl;
+    
+    // Calculate final average wait times
+    float avg_reader_wait = stats.total_reads > 0 ? 
+                             static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+    float avg_writer_wait = stats.total_writes > 0 ? 
+                             static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+    
+    std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+    std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+    
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
+    return 0;
+}
@@ -0,0 +1,565 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <algorithm>
+#include <string>
+#include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_fifo.h"
+#include "readers_writers_map.h"
+#include "readers_writers_parking.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
+
+// Readers-Writers locks on the global parking lot (readers_writers_parking.h)
+// Both locks below are a single 32-bit word; everything needed to block lives in the
+// parking lot and exists only per waiting thread. PARKING_POLICY picks the lock:
+//   writers  writer-priority, the policy of readers_writers.cpp (default)
+//   fair     FIFO order with reader batching, the policy of readers_writers_fair.cpp
+
+// Slow-path statistics, shared by every lock of one policy
+struct ParkingLockStats {
+    WaitStrategy wait;
+    std::atomic<long long> reads{0};            // Read acquisitions that missed the fast path
+    std::atomic<long long> writes{0};           // Write acquisitions that missed the fast path
+    std::atomic<long long> handoffs{0};         // Ownership passed straight to parked threads
+    
+    void print_report(const char* policy, size_t lock_size, size_t lock_align) const {
+        std::cout << "\n----- PARKING LOT LOCK -----" << std::endl;
+        std::cout << "Policy: " << policy << ", lock size: " << lock_size << " bytes (alignment "
+                  << lock_align << ")" << std::endl;
+        std::cout << "Slow-path acquisitions (reads/writes): " << reads << " / " << writes << std::endl;
+        std::cout << "Direct handoffs: " << handoffs << std::endl;
+        ParkingLot::global().print_report();
+        wait.print_report();
+    }
+};
+
+// Writer-priority lock. Same word layout as CompactReadersWriterLock, but readers and
+// writers park on two different keys (the word's address and the next byte), so a
+// release wakes only the threads that can make progress: one writer while writers wait,
+// otherwise every parked reader.
+class ParkingWritersPriorityLock {
+private:
+    static constexpr uint32_t READER_MASK = 0xFFFF;
+    static constexpr uint32_t WAITING_WRITER = 1u << 16;
+    static constexpr uint32_t WAITING_WRITER_MASK = 0x3FFFu << 16;
+    static constexpr uint32_t READERS_PARKED = 1u << 30;
+    static constexpr uint32_t WRITER = 1u << 31;
+    
+    std::atomic<uint32_t> state{0};
+    
+    const void* reader_key() const {
+        return &state;
+    }
+    
+    const void* writer_key() const {
+        return reinterpret_cast<const char*>(&state) + 1;
+    }
+    
+    static bool readers_admitted(uint32_t word) {
+        return (word & (WRITER | WAITING_WRITER_MASK)) == 0 && (word & READER_MASK) != READER_MASK;
+    }
+    
+    static bool writer_admitted(uint32_t word) {
+        return (word & (WRITER | READER_MASK)) == 0;
+    }
+    
+    // Park on `key` unless the word has moved on from `expected`
+    void park(const void* key, uint32_t expected) {
+        ParkingLot::global().park(key, 0, [this, expected] {
+            return state.load(std::memory_order_relaxed) == expected;
+        });
+    }
+    
+    static intptr_t no_token(ParkingLot::UnparkResult) {
+        return 0;
+    }
+    
+public:
+    static ParkingLockStats& stats() {
+        static ParkingLockStats shared;
+        return shared;
+    }
+    
+    bool try_read_lock() {
+        uint32_t word = state.load(std::memory_order_relaxed);
+        return readers_admitted(word) &&
+               state.compare_exchange_strong(word, word + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+    
+    bool try_write_lock() {
+        uint32_t word = state.load(std::memory_order_relaxed);
+        return writer_admitted(word) &&
+               state.compare_exchange_strong(word, word | WRITER, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+    
+    void read_lock() {
+        if (try_read_lock()) return;
+        stats().reads.fetch_add(1, std::memory_order_relaxed);
+        stats().wait.acquire([this] { return try_read_lock(); }, [this] {
+            for (;;) {
+                uint32_t word = state.load(std::memory_order_relaxed);
+                if (readers_admitted(word)) {
+                    if (state.compare_exchange_weak(word, word + 1, std::memory_order_acquire, std::memory_order_relaxed)) return;
+                } else if ((word & READER_MASK) == READER_MASK && (word & (WRITER | WAITING_WRITER_MASK)) == 0) {
+                    std::this_thread::yield();    // Reader count saturated; nobody will wake us
+                } else if ((word & READERS_PARKED) ||
+                           state.compare_exchange_weak(word, word | READERS_PARKED, std::memory_order_relaxed)) {
+                    park(reader_key(), word | READERS_PARKED);
+                }
+            }
+        });
+    }
+    
+    void read_unlock() {
+        uint32_t previous = state.fetch_sub(1, std::memory_order_release);
+        if ((previous & READER_MASK) == 1 && (previous & WAITING_WRITER_MASK) != 0) {
+            ParkingLot::global().unpark_one(writer_key(), no_token);
+        }
+    }
+    
+    void write_lock() {
+        if (try_write_lock()) return;
+        stats().writes.fetch_add(1, std::memory_order_relaxed);
+        stats().wait.acquire([this] { return try_write_lock(); }, [this] {
+            // Counting ourselves as waiting keeps new readers out until we are in
+            state.fetch_add(WAITING_WRITER, std::memory_order_relaxed);
+            for (;;) {
+                uint32_t word = state.load(std::memory_order_relaxed);
+                if (writer_admitted(word)) {
+                    if (state.compare_exchange_weak(word, (word - WAITING_WRITER) | WRITER,
+                                                    std::memory_order_acquire, std::memory_order_relaxed)) return;
+                } else {
+                    park(writer_key(), word);
+                }
+            }
+        });
+    }
+    
+    void write_unlock() {
+        // Waiting writers go first; parked readers are released only once none are left
+        uint32_t word = state.load(std::memory_order_relaxed);
+        uint32_t next;
+        do {
+            next = word & ~WRITER;
+            if ((word & WAITING_WRITER_MASK) == 0) next &= ~READERS_PARKED;
+        } while (!state.compare_exchange_weak(word, next, std::memory_order_release, std::memory_order_relaxed));
+        
+        if ((word & WAITING_WRITER_MASK) != 0) {
+            ParkingLot::global().unpark_one(writer_key(), no_token);
+        } else if ((word & READERS_PARKED) != 0) {
+            ParkingLot::global().unpark_all(reader_key());
+        }
+    }
+};
+
+// FIFO lock with the admission rules of FairReadersWriterLock: once anyone is parked,
+// newcomers queue behind them, and a release grants the head of the queue - one writer,
+// or the whole run of readers up to the next writer. Requests queue in the parking lot in
+// arrival order with their type as park token, and the releasing thread hands the lock
+// over directly: it sets the word for the threads it unparks while still holding the
+// bucket mutex, so nobody can slip in between. Fairness thus costs no memory in the lock.
+class ParkingFairLock {
+private:
+    static constexpr uint32_t READER_MASK = 0x3FFFFFFF;
+    static constexpr uint32_t WRITER = 1u << 30;
+    static constexpr uint32_t QUEUED = 1u << 31;  // Threads are parked; only set or cleared under the bucket mutex
+    
+    static constexpr intptr_t HANDOFF = 1;
+    
+    std::atomic<uint32_t> state{0};
+    
+    static bool admits(RequestType type, uint32_t word) {
+        if (type == RequestType::WRITE) return word == 0;
+        return (word & (WRITER | QUEUED)) == 0 && (word & READER_MASK) != READER_MASK;
+    }
+    
+    // Queue behind the parked threads unless the lock has become free for us meanwhile.
+    // Returns once the lock was handed over, or when the fast path should be retried.
+    bool park(RequestType type) {
+        auto result = ParkingLot::global().park(&state, static_cast<intptr_t>(type), [this, type] {
+            uint32_t word = state.load(std::memory_order_relaxed);
+            for (;;) {
+                if (word & QUEUED) return true;
+                if (admits(type, word)) return false;
+                if (state.compare_exchange_weak(word, word | QUEUED, std::memory_order_relaxed)) return true;
+            }
+        });
+        return result.parked && result.token == HANDOFF;
+    }
+    
+    // Called with the lock released but QUEUED still set, so no one else can acquire it
+    void grant() {
+        bool first = true;
+        bool writer_first = false;
+        ParkingLot::global().unpark_filter(&state, [&](intptr_t token) {
+            bool writer = token == static_cast<intptr_t>(RequestType::WRITE);
+            if (first) {
+                first = false;
+                writer_first = writer;
+                return ParkingLot::FilterResult::UNPARK;
+            }
+            return writer_first || writer ? ParkingLot::FilterResult::STOP : ParkingLot::FilterResult::UNPARK;
+        }, [&](ParkingLot::UnparkResult result) {
+            uint32_t granted = result.unparked == 0 ? 0 : writer_first ? WRITER : static_cast<uint32_t>(result.unparked);
+            state.store(granted | (result.have_more ? QUEUED : 0), std::memory_order_release);
+            stats().handoffs.fetch_add(result.unparked, std::memory_order_relaxed);
+            return HANDOFF;
+        });
+    }
+    
+    void acquire_slow(RequestType type) {
+        (type == RequestType::READ ? stats().reads : stats().writes).fetch_add(1, std::memory_order_relaxed);
+        auto try_acquire = [this, type] { return type == RequestType::READ ? try_read_lock() : try_write_lock(); };
+        stats().wait.acquire(try_acquire, [this, type, try_acquire] {
+            while (!try_acquire()) {
+                if (park(type)) return;
+            }
+        });
+    }
+    
+public:
+    static ParkingLockStats& stats() {
+        static ParkingLockStats shared;
+        return shared;
+    }
+    
+    bool try_read_lock() {
+        uint32_t word = state.load(std::memory_order_relaxed);
+        return admits(RequestType::READ, word) &&
+               state.compare_exchange_strong(word, word + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+    
+    bool try_write_lock() {
+        uint32_t word = 0;
+        return state.compare_exchange_strong(word, WRITER, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+    
+    void read_lock() {
+        if (!try_read_lock()) acquire_slow(RequestType::READ);
+    }
+    
+    void read_unlock() {
+        uint32_t previous = state.fetch_sub(1, std::memory_order_release);
+        if ((previous & READER_MASK) == 1 && (previous & QUEUED) != 0) grant();
+    }
+    
+    void write_lock() {
+        if (!try_write_lock()) acquire_slow(RequestType::WRITE);
+    }
+    
+    void write_unlock() {
+        uint32_t word = WRITER;
+        if (state.compare_exchange_strong(word, 0, std::memory_order_release, std::memory_order_relaxed)) return;
+        // Parked threads: the word stays WRITER | QUEUED until grant() replaces it
+        grant();
+    }
+};
+
+// Shared resource (simulated as an integer), guarded by either parking lot lock
+template <typename Lock>
+class SharedResource {
+private:
+    int data = 0;
+    Lock rwlock;
+    std::mutex print_mutex;  // For synchronized console output
+    
+public:
+    // Reader function: reads data from the shared resource
+    OpTiming reader(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " wants to read." << std::endl;
+        }
+        
+        // Acquire read lock
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        rwlock.read_lock();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " is reading data: " << data 
+                      << " (waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Simulate reading process
+        std::this_thread::sleep_for(std::chrono::milliseconds(100 + (rand() % 900)));
+        
+        // Release read lock
+        rwlock.read_unlock();
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " finished reading." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Writer function: modifies the shared resource
+    OpTiming writer(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " wants to write." << std::endl;
+        }
+        
+        // Acquire write lock
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        rwlock.write_lock();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        // Simulate writing process
+        int new_value = rand() % 1000;
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " is writing data: " << new_value 
+                      << " (waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Modify the shared data
+        data = new_value;
+        
+        // Simulate additional processing
+        std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
+        
+        // Release write lock
+        rwlock.write_unlock();
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " finished writing." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Get the current data value
+    int get_data() const {
+        return data;
+    }
+    
+    // Print the slow-path statistics of this policy and the parking lot behind it
+    void print_lock_stats(const char* policy) const {
+        Lock::stats().print_report(policy, sizeof(Lock), alignof(Lock));
+    }
+};
+
+// Statistics for the demonstration
+struct Statistics {
+    std::atomic<int> total_reads{0};
+    std::atomic<int> total_writes{0};
+    std::atomic<int> readers_waiting{0};
+    std::atomic<int> writers_waiting{0};
+    std::atomic<long long> reader_wait_time{0};
+    std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(const char* policy, int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace(policy, num_readers, num_writers, operations_per_thread) {}
+};
+
+// The demonstration, run with the lock PARKING_POLICY selected
+template <typename Lock>
+int run_demonstration(const char* policy) {
+    // Create shared resource
+    SharedResource<Lock> resource;
+    
+    // Create threads for readers and writers
+    // Use environment variables if provided, otherwise use defaults
+    const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
+    const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
+    const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(policy, num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
+    
+    std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
+              << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
+    
+    std::vector<std::thread> threads;
+    
+    std::cout << "Starting readers-writers demonstration (PARKING LOT, " << policy << ") with "
+              << num_readers << " readers and " 
+              << num_writers << " writers." << std::endl;
+    
+    // Lambda to simulate reader behavior with random intervals
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to read
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.readers_waiting++;
+            OpTiming timing = resource.reader(id);
+            stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_reads++;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
+        }
+    };
+    
+    // Lambda to simulate writer behavior with random intervals
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to write
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.writers_waiting++;
+            OpTiming timing = resource.writer(id);
+            stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_writes++;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
+        }
+    };
+    
+    // Start reader threads
+    for (int i = 0; i < num_readers; i++) {
+        threads.emplace_back(reader_task, i + 1);
+    }
+    
+    // Start writer threads
+    for (int i = 0; i < num_writers; i++) {
+        threads.emplace_back(writer_task, i + 1);
+    }
+    
+    // Monitor thread for displaying statistics
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
+        int expected_operations = (num_readers + num_writers) * operations_per_thread;
+        int total_operations = 0;
+        
+        while (!run.done(total_operations, expected_operations)) {
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            total_operations = stats.total_reads + stats.total_writes;
+            
+            std::cout << "\n----- STATISTICS -----" << std::endl;
+            std::cout << "Completed reads: " << stats.total_reads << std::endl;
+            std::cout << "Completed writes: " << stats.total_writes << std::endl;
+            std::cout << "Readers waiting: " << stats.readers_waiting << std::endl;
+            std::cout << "Writers waiting: " << stats.writers_waiting << std::endl;
+            
+            // Calculate average wait times
+            float avg_reader_wait = stats.total_reads > 0 ? 
+                                     static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+            float avg_writer_wait = stats.total_writes > 0 ? 
+                                     static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+            
+            std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+            std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
+        }
+    });
+    
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
+    // Wait for all threads to complete
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    run.finish();
+    
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+    
+    std::cout << "\nDemonstration completed!" << std::endl;
+    std::cout << "Final statistics:" << std::endl;
+    std::cout << "Total reads: " << stats.total_reads << std::endl;
+    std::cout << "Total writes: " << stats.total_writes << std::endl;
+    
+    // Calculate final average wait times
+    float avg_reader_wait = stats.total_reads > 0 ? 
+                             static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+    float avg_writer_wait = stats.total_writes > 0 ? 
+                             static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+    
+    std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+    std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+    
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats(policy);
+    stats.trace.write();
+    
+    return 0;
+}
+
+int main() {
+    // Seed for random number generation
+    srand(static_cast<unsigned int>(time(nullptr)));
+    
+    std::string policy = std::getenv("PARKING_POLICY") ? std::getenv("PARKING_POLICY") : "writers";
+    if (policy != "writers" && policy != "fair") {
+        std::cerr << "Unknown PARKING_POLICY '" << policy << "', using writers" << std::endl;
+        policy = "writers";
+    }
+    const bool fair = policy == "fair";
+    const char* name = fair ? "Parking Lot (fair)" : "Parking Lot (writers)";
+    
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        const char* note = "the process-wide parking lot (PARKING_LOT_BUCKETS 64-byte buckets) and one wait record per thread that blocks";
+        return fair ? print_lock_footprint<ParkingFairLock>(name, "ParkingFairLock", note)
+                    : print_lock_footprint<ParkingWritersPriorityLock>(name, "ParkingWritersPriorityLock", note);
+    }
+    
+    // WORKLOAD=map benchmarks a striped hash map built on this lock instead
+    if (map_workload_requested()) {
+        return fair ? run_map_benchmark<ParkingFairLock>(name) : run_map_benchmark<ParkingWritersPriorityLock>(name);
+    }
+    
+    return fair ? run_demonstration<ParkingFairLock>(name) : run_demonstration<ParkingWritersPriorityLock>(name);
+}
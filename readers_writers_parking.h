@@ -0,0 +1,219 @@
+/**
+ * readers_writers_parking.h - Global parking lot: wait queues keyed by address
+ *
+ * The locks in the other programs each own their condition variables, so a lock is as
+ * large as its waiting machinery even when nobody ever waits. The parking lot (after
+ * WebKit's WTF::ParkingLot and Rust's parking_lot) moves that machinery into one
+ * process-wide hash table. A lock only keeps an atomic word; a thread that has to block
+ * parks on an address (usually the lock word), and a releasing thread unparks by the same
+ * address. Waiter state is one ThreadData per thread that has ever parked, so memory
+ * grows with the number of threads, not the number of locks.
+ *
+ *   park(addr, token, validate)    Under the bucket mutex, call validate(); if it returns
+ *                                  true, queue the calling thread with `token` and sleep
+ *                                  until unparked. Returns whether the thread slept and
+ *                                  the token the unparker handed over.
+ *   unpark_filter(addr, filter, callback)
+ *                                  Walk the threads parked on `addr` in FIFO order; filter
+ *                                  decides per park token whether to wake, skip or stop.
+ *                                  callback(result) runs before anyone wakes, still under
+ *                                  the bucket mutex, and returns the token every woken
+ *                                  thread receives - this is where a lock hands itself
+ *                                  over directly.
+ *   unpark_one(addr, callback), unpark_all(addr)
+ *
+ * validate() and the callbacks run under the same bucket mutex, so a lock that changes its
+ * word before unparking can never miss a thread that is about to park. Buckets are cache
+ * aligned; their number is fixed by PARKING_LOT_BUCKETS (default 256). The report includes
+ * the unpark-to-running latency of woken threads, i.e. the cost of a handoff through the lot.
+ */
+
+#ifndef READERS_WRITERS_PARKING_H
+#define READERS_WRITERS_PARKING_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ParkingLot {
+public:
+    enum class FilterResult { UNPARK, SKIP, STOP };
+
+    struct ParkResult {
+        bool parked = false;            // False if validate() refused
+        intptr_t token = 0;             // Handed over by the unparker
+    };
+
+    struct UnparkResult {
+        int unparked = 0;
+        bool have_more = false;         // Threads are still parked on the address
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // One per thread, queued in the bucket of the address it parks on
+    struct ThreadData {
+        std::condition_variable cv;
+        const void* address = nullptr;
+        intptr_t park_token = 0;
+        intptr_t unpark_token = 0;
+        bool parked = false;
+        Clock::time_point unparked_at;
+        ThreadData* next = nullptr;
+    };
+
+    struct alignas(64) Bucket {
+        std::mutex mtx;
+        ThreadData* head = nullptr;
+        ThreadData* tail = nullptr;
+    };
+
+    size_t bucket_count;
+    std::unique_ptr<Bucket[]> buckets;
+
+    std::atomic<long long> threads{0};          // ThreadData instances created
+    std::atomic<long long> parks{0};
+    std::atomic<long long> refused{0};          // validate() returned false
+    std::atomic<long long> unparks{0};
+    std::atomic<long long> parked_now{0};
+    std::atomic<long long> peak_parked{0};
+    std::atomic<long long> handoff_ns{0};       // Unpark -> woken thread running, summed
+    std::atomic<long long> max_handoff_ns{0};
+
+    ParkingLot()
+        : bucket_count(std::max(1, std::getenv("PARKING_LOT_BUCKETS") ? std::stoi(std::getenv("PARKING_LOT_BUCKETS")) : 256)),
+          buckets(new Bucket[bucket_count]) {}
+
+    Bucket& bucket_for(const void* address) {
+        uint64_t h = reinterpret_cast<uintptr_t>(address) * 0x9e3779b97f4a7c15ULL;
+        return buckets[(h >> 32) % bucket_count];
+    }
+
+    ThreadData& thread_data() {
+        thread_local ThreadData* data = nullptr;
+        if (data == nullptr) {
+            thread_local ThreadData storage;
+            data = &storage;
+            threads.fetch_add(1, std::memory_order_relaxed);
+        }
+        return *data;
+    }
+
+    static void update_max(std::atomic<long long>& max, long long value) {
+        long long seen = max.load(std::memory_order_relaxed);
+        while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    }
+
+public:
+    static ParkingLot& global() {
+        static ParkingLot lot;
+        return lot;
+    }
+
+    template <typename Validate>
+    ParkResult park(const void* address, intptr_t token, Validate validate) {
+        ThreadData& me = thread_data();
+        Bucket& bucket = bucket_for(address);
+        std::unique_lock<std::mutex> guard(bucket.mtx);
+        if (!validate()) {
+            refused.fetch_add(1, std::memory_order_relaxed);
+            return {};
+        }
+
+        me.address = address;
+        me.park_token = token;
+        me.parked = true;
+        me.next = nullptr;
+        (bucket.tail != nullptr ? bucket.tail->next : bucket.head) = &me;
+        bucket.tail = &me;
+        parks.fetch_add(1, std::memory_order_relaxed);
+        update_max(peak_parked, parked_now.fetch_add(1, std::memory_order_relaxed) + 1);
+
+        me.cv.wait(guard, [&me] { return !me.parked; });
+        long long latency = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - me.unparked_at).count();
+        handoff_ns.fetch_add(latency, std::memory_order_relaxed);
+        update_max(max_handoff_ns, latency);
+        return {true, me.unpark_token};
+    }
+
+    // `filter(park_token)` is asked for each thread parked on `address`, oldest first
+    template <typename Filter, typename Callback>
+    UnparkResult unpark_filter(const void* address, Filter filter, Callback callback) {
+        Bucket& bucket = bucket_for(address);
+        std::lock_guard<std::mutex> guard(bucket.mtx);
+
+        std::vector<ThreadData*> woken;
+        UnparkResult result;
+        bool stopped = false;
+        ThreadData* previous = nullptr;
+        for (ThreadData* data = bucket.head; data != nullptr;) {
+            ThreadData* next = data->next;
+            if (data->address == address) {
+                FilterResult decision = stopped ? FilterResult::STOP : filter(data->park_token);
+                if (decision == FilterResult::UNPARK) {
+                    (previous != nullptr ? previous->next : bucket.head) = next;
+                    if (bucket.tail == data) bucket.tail = previous;
+                    woken.push_back(data);
+                    data = next;
+                    continue;
+                }
+                if (decision == FilterResult::STOP) stopped = true;
+                result.have_more = true;
+            }
+            previous = data;
+            data = next;
+        }
+
+        result.unparked = static_cast<int>(woken.size());
+        intptr_t token = callback(result);
+
+        // Notify under the bucket mutex: a woken thread cannot return (and retire its
+        // ThreadData) before we are done with it
+        Clock::time_point now = Clock::now();
+        for (ThreadData* data : woken) {
+            data->unpark_token = token;
+            data->unparked_at = now;
+            data->parked = false;
+            data->cv.notify_one();
+        }
+        unparks.fetch_add(woken.size(), std::memory_order_relaxed);
+        parked_now.fetch_sub(woken.size(), std::memory_order_relaxed);
+        return result;
+    }
+
+    template <typename Callback>
+    UnparkResult unpark_one(const void* address, Callback callback) {
+        bool found = false;
+        return unpark_filter(address, [&found](intptr_t) {
+            if (found) return FilterResult::STOP;
+            found = true;
+            return FilterResult::UNPARK;
+        }, callback);
+    }
+
+    int unpark_all(const void* address) {
+        return unpark_filter(address, [](intptr_t) { return FilterResult::UNPARK; },
+                             [](UnparkResult) { return intptr_t(0); }).unparked;
+    }
+
+    void print_report() const {
+        std::cout << "\n----- PARKING LOT -----" << std::endl;
+        std::cout << "Buckets: " << bucket_count << " (" << bucket_count * sizeof(Bucket) << " bytes), thread records: "
+                  << threads << " (" << threads * static_cast<long long>(sizeof(ThreadData)) << " bytes)" << std::endl;
+        std::cout << "Parks: " << parks << " (refused by validation: " << refused << "), unparks: " << unparks << std::endl;
+        std::cout << "Peak parked threads: " << peak_parked << std::endl;
+        std::cout << "Avg unpark-to-running latency: " << (unparks > 0 ? handoff_ns / 1000.0 / unparks : 0.0)
+                  << " us (max " << max_handoff_ns / 1000.0 << " us)" << std::endl;
+    }
+};
+
+#endif // READERS_WRITERS_PARKING_H
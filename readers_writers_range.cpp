@@ -0,0 +1,407 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_range.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+
+// Shared resource: a RANGE_BUFFER-byte buffer (default 65536) standing in for a file.
+// Every operation covers RANGE_LEN bytes (default 4096) at a random offset and locks only
+// that range, so readers and writers of disjoint ranges proceed together. Writers fill
+// their range with one byte value; readers copy their range, hold it for the simulated
+// read and compare it again before unlocking, which would expose any write that slipped
+// into a locked range.
+class SharedResource {
+private:
+    std::vector<uint8_t> buffer;
+    uint64_t range_len;
+    RangeLock rwlock;
+    std::atomic<long long> torn_reads{0};
+    std::mutex print_mutex;  // For synchronized console output
+    
+    static long long env_or(const char* name, long long fallback) {
+        return std::getenv(name) ? std::stoll(std::getenv(name)) : fallback;
+    }
+    
+    uint64_t pick_offset() const {
+        return ((static_cast<uint64_t>(rand()) << 31) ^ rand()) % (buffer.size() - range_len + 1);
+    }
+    
+public:
+    SharedResource()
+        : buffer(std::max(1LL, env_or("RANGE_BUFFER", 65536)), 0),
+          range_len(std::min<uint64_t>(buffer.size(), std::max(1LL, env_or("RANGE_LEN", 4096)))),
+          rwlock(buffer.size()) {}
+    
+    // Reader function: reads one range of the buffer under a shared range lock
+    OpTiming reader(int id) {
+        uint64_t offset = pick_offset();
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " wants to read bytes [" << offset << ", " << offset + range_len << ")." << std::endl;
+        }
+        
+        // Acquire a shared lock on the range
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        rwlock.read_lock(offset, range_len);
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        std::vector<uint8_t> copy(buffer.begin() + offset, buffer.begin() + offset + range_len);
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " is reading data: " << static_cast<int>(copy.front())
+                      << " (bytes [" << offset << ", " << offset + range_len << "), waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Simulate reading process
+        std::this_thread::sleep_for(std::chrono::milliseconds(100 + (rand() % 900)));
+        if (std::memcmp(copy.data(), buffer.data() + offset, range_len) != 0) torn_reads++;
+        
+        // Release the shared lock
+        rwlock.read_unlock(offset, range_len);
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " finished reading." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Writer function: overwrites one range of the buffer under an exclusive range lock
+    OpTiming writer(int id) {
+        uint64_t offset = pick_offset();
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " wants to write bytes [" << offset << ", " << offset + range_len << ")." << std::endl;
+        }
+        
+        // Acquire an exclusive lock on the range
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        rwlock.write_lock(offset, range_len);
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        // Simulate writing process
+        uint8_t new_value = rand() % 256;
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " is writing data: " << static_cast<int>(new_value)
+                      << " (bytes [" << offset << ", " << offset + range_len << "), waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Modify the shared data
+        std::memset(buffer.data() + offset, new_value, range_len);
+        
+        // Simulate additional processing
+        std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
+        
+        // Release the exclusive lock
+        rwlock.write_unlock(offset, range_len);
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " finished writing." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Print how often ranges collided, and verify that no read saw a concurrent write
+    void print_lock_stats() {
+        rwlock.print_report();
+        std::cout << "Range length: " << range_len << " of " << buffer.size() << " bytes" << std::endl;
+        std::cout << "Reads changed while locked: " << torn_reads << std::endl;
+    }
+};
+
+// Whole-resource baseline for the range benchmark
+struct WholeResourceLock {
+    std::shared_mutex mtx;
+    
+    void read_lock(uint64_t, uint64_t) { mtx.lock_shared(); }
+    void read_unlock(uint64_t, uint64_t) { mtx.unlock_shared(); }
+    void write_lock(uint64_t, uint64_t) { mtx.lock(); }
+    void write_unlock(uint64_t, uint64_t) { mtx.unlock(); }
+};
+
+// Ops/s of one benchmark configuration. Each thread owns a region of four range lengths;
+// `overlap_percent` of its operations go to region 0 instead, which every thread shares.
+template <typename Lock>
+double range_throughput(Lock& lock, std::vector<uint8_t>& buffer, int threads, long long ops,
+                        uint64_t len, int overlap_percent, int read_percent) {
+    const uint64_t region = 4 * len;
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::mt19937_64 gen(t + 1);
+            std::uniform_int_distribution<uint64_t> offset_dist(0, region - len);
+            std::uniform_int_distribution<int> percent(0, 99);
+            long long sum = 0;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (long long i = 0; i < ops; i++) {
+                uint64_t base = percent(gen) < overlap_percent ? 0 : t * region;
+                uint64_t offset = base + offset_dist(gen);
+                if (percent(gen) < read_percent) {
+                    lock.read_lock(offset, len);
+                    for (uint64_t b = offset; b < offset + len; b++) sum += buffer[b];
+                    lock.read_unlock(offset, len);
+                } else {
+                    lock.write_lock(offset, len);
+                    std::memset(buffer.data() + offset, static_cast<int>(i), len);
+                    lock.write_unlock(offset, len);
+                }
+            }
+            if (sum == -1) std::cout << "";   // Keep the reads from being optimised away
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) worker.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * ops / seconds;
+}
+
+// WORKLOAD=ranges: range lock against whole-resource locking for every range length in
+// RANGE_BENCH_LENS and overlap share in RANGE_BENCH_OVERLAPS
+int run_range_benchmark() {
+    auto env_or = [](const char* name, long long fallback) {
+        return std::getenv(name) ? std::stoll(std::getenv(name)) : fallback;
+    };
+    auto env_list = [](const char* name, const char* fallback) {
+        std::istringstream in(std::getenv(name) ? std::getenv(name) : fallback);
+        std::vector<long long> values;
+        for (long long value; in >> value;) values.push_back(value);
+        return values;
+    };
+    const int threads = std::max(1LL, env_or("RANGE_BENCH_THREADS", 4));
+    const long long ops = std::max(1LL, env_or("RANGE_BENCH_OPS", 20000));
+    const int read_percent = env_or("RANGE_BENCH_READ_PERCENT", 70);
+    
+    std::cout << "\n----- RANGE BENCHMARK -----" << std::endl;
+    std::cout << "Threads: " << threads << ", operations per thread: " << ops << ", reads: " << read_percent << "%" << std::endl;
+    std::cout << "Range len | Overlap % | Range lock ops/s | Whole-resource ops/s | Speedup" << std::endl;
+    for (long long len : env_list("RANGE_BENCH_LENS", "64 4096 65536")) {
+        len = std::max(1LL, len);
+        std::vector<uint8_t> buffer(threads * 4 * len, 0);
+        for (long long overlap : env_list("RANGE_BENCH_OVERLAPS", "0 10 50 100")) {
+            RangeLock ranges(buffer.size());
+            WholeResourceLock whole;
+            double ranged = range_throughput(ranges, buffer, threads, ops, len, overlap, read_percent);
+            double global = range_throughput(whole, buffer, threads, ops, len, overlap, read_percent);
+            std::cout << len << " | " << overlap << " | " << ranged << " | " << global
+                      << " | " << ranged / global << "x" << std::endl;
+        }
+    }
+    return 0;
+}
+
+// Statistics for the demonstration
+struct Statistics {
+    std::atomic<int> total_reads{0};
+    std::atomic<int> total_writes{0};
+    std::atomic<int> readers_waiting{0};
+    std::atomic<int> writers_waiting{0};
+    std::atomic<long long> reader_wait_time{0};
+    std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("Range Lock", num_readers, num_writers, operations_per_thread) {}
+};
+
+int main() {
+    // Seed for random number generation
+    srand(static_cast<unsigned int>(time(nullptr)));
+    
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<RangeLock>("Range Lock", "RangeLock",
+                                               "RANGE_BUFFER / RANGE_SEGMENT 64-byte segments, one index node per range and segment held or queued");
+    }
+    
+    // WORKLOAD=ranges compares the range lock with whole-resource locking instead
+    if (std::getenv("WORKLOAD") && std::string(std::getenv("WORKLOAD")) == "ranges") {
+        return run_range_benchmark();
+    }
+    
+    // Create shared resource
+    SharedResource resource;
+    
+    // Create threads for readers and writers
+    // Use environment variables if provided, otherwise use defaults
+    const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
+    const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
+    const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
+    
+    std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
+              << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
+    
+    std::vector<std::thread> threads;
+    
+    std::cout << "Starting readers-writers demonstration (RANGE LOCK) with "
+              << num_readers << " readers and " 
+              << num_writers << " writers." << std::endl;
+    
+    // Lambda to simulate reader behavior with random intervals
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to read
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.readers_waiting++;
+            OpTiming timing = resource.reader(id);
+            stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_reads++;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
+        }
+    };
+    
+    // Lambda to simulate writer behavior with random intervals
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to write
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.writers_waiting++;
+            OpTiming timing = resource.writer(id);
+            stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_writes++;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
+        }
+    };
+    
+    // Start reader threads
+    for (int i = 0; i < num_readers; i++) {
+        threads.emplace_back(reader_task, i + 1);
+    }
+    
+    // Start writer threads
+    for (int i = 0; i < num_writers; i++) {
+        threads.emplace_back(writer_task, i + 1);
+    }
+    
+    // Monitor thread for displaying statistics
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
+        int expected_operations = (num_readers + num_writers) * operations_per_thread;
+        int total_operations = 0;
+        
+        while (!run.done(total_operations, expected_operations)) {
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            total_operations = stats.total_reads + stats.total_writes;
+            
+            std::cout << "\n----- STATISTICS -----" << std::endl;
+            std::cout << "Completed reads: " << stats.total_reads << std::endl;
+            std::cout << "Completed writes: " << stats.total_writes << std::endl;
+            std::cout << "Readers waiting: " << stats.readers_waiting << std::endl;
+            std::cout << "Writers waiting: " << stats.writers_waiting << std::endl;
+            
+            // Calculate average wait times
+            float avg_reader_wait = stats.total_reads > 0 ? 
+                                     static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+            float avg_writer_wait = stats.total_writes > 0 ? 
+                                     static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+            
+            std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+            std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
+        }
+    });
+    
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
+    // Wait for all threads to complete
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    run.finish();
+    
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+    
+    std::cout << "\nDemonstration completed!" << std::endl;
+    std::cout << "Final statistics:" << std::endl;
+    std::cout << "Total reads: " << stats.total_reads << std::endl;
+    std::cout << "Total writes: " << stats.total_writes << std::endl;
+    
+    // Calculate final average wait times
+    float avg_reader_wait = stats.total_reads > 0 ? 
+                             static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+    float avg_writer_wait = stats.total_writes > 0 ? 
+                             static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+    
+    std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+    std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+    
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
+    return 0;
+}
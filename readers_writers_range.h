@@ -0,0 +1,173 @@
+/**
+ * readers_writers_range.h - Byte-range reader/writer lock
+ *
+ * RangeLock guards a resource of `size` bytes (a buffer or a file) by offset range:
+ *
+ *   read_lock(offset, len)   shared access to [offset, offset + len)
+ *   write_lock(offset, len)  exclusive access to [offset, offset + len)
+ *
+ * and the matching unlocks with the same arguments. Two requests conflict only when their
+ * ranges overlap and at least one of them writes. Without arguments the calls cover the
+ * whole resource, so a RangeLock also works wherever a plain reader/writer lock is
+ * expected.
+ *
+ * The offset space is cut into segments of `segment_size` bytes (RANGE_SEGMENT, default
+ * 4096). Each segment has its own mutex and an interval index of the requests touching
+ * it, sorted by start; a request is clipped to each segment, so no indexed interval is
+ * longer than a segment and an overlap query only has to look back one segment length
+ * from its start. Requests that fall in different segments never share a mutex or cache
+ * line, which is the fast path for disjoint I/O; a request spanning several segments
+ * acquires them in ascending order, which rules out deadlock between spanning requests.
+ *
+ * Within a segment requests are granted in arrival order among those that overlap: a
+ * request also waits for earlier queued requests it conflicts with, so a stream of
+ * overlapping readers cannot starve a writer. Disjoint requests never wait for each other.
+ */
+
+#ifndef READERS_WRITERS_RANGE_H
+#define READERS_WRITERS_RANGE_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "readers_writers_wait.h"
+
+class RangeLock {
+private:
+    struct Entry {
+        uint64_t end;           // Exclusive, clipped to the segment
+        bool write;
+        bool granted;
+        uint64_t ticket;        // Arrival order within the segment
+    };
+
+    // Interval index of one segment: start -> entry, several entries may share a start
+    using Index = std::multimap<uint64_t, Entry>;
+
+    static constexpr uint64_t MAX_SEGMENTS = 1 << 20;
+
+    struct alignas(64) Segment {
+        std::mutex mtx;
+        std::condition_variable released;
+        Index index;
+        uint64_t next_ticket = 0;
+        long long grants = 0;
+        long long waits = 0;                    // Grants that had to wait for a conflict
+    };
+
+    uint64_t total_size;
+    uint64_t segment_size;
+    size_t segment_count;
+    std::unique_ptr<Segment[]> segments;
+    WaitStrategy wait;
+    std::atomic<long long> spanning{0};         // Requests that covered more than one segment
+
+    // Does the entry at `self` have to wait? It conflicts with overlapping entries that are
+    // granted, or queued before it, unless both only read
+    bool blocked(const Segment& segment, Index::const_iterator self) const {
+        uint64_t start = self->first;
+        const Entry& entry = self->second;
+        auto first = segment.index.lower_bound(start >= segment_size ? start - segment_size : 0);
+        auto last = segment.index.lower_bound(entry.end);
+        for (auto it = first; it != last; ++it) {
+            if (it == self || it->second.end <= start) continue;
+            if (!entry.write && !it->second.write) continue;
+            if (it->second.granted || it->second.ticket < entry.ticket) return true;
+        }
+        return false;
+    }
+
+    // Call fn(segment, begin, end) for each segment the clipped range touches, in ascending
+    // order; returns the number of segments
+    template <typename Fn>
+    size_t for_each_segment(uint64_t offset, uint64_t len, Fn fn) {
+        uint64_t begin = std::min(offset, total_size);
+        uint64_t end = len > total_size - begin ? total_size : begin + len;
+        if (begin >= end) return 0;
+        size_t first = begin / segment_size;
+        size_t last = (end - 1) / segment_size;
+        for (size_t i = first; i <= last; i++) {
+            uint64_t seg_begin = i * segment_size;
+            fn(segments[i], std::max(begin, seg_begin), std::min(end, seg_begin + segment_size));
+        }
+        return last - first + 1;
+    }
+
+    void lock(uint64_t offset, uint64_t len, bool write) {
+        size_t touched = for_each_segment(offset, len, [this, write](Segment& segment, uint64_t begin, uint64_t end) {
+            std::unique_lock<std::mutex> guard(segment.mtx);
+            auto self = segment.index.emplace(begin, Entry{end, write, false, segment.next_ticket++});
+            if (blocked(segment, self)) segment.waits++;
+            wait.wait(guard, segment.released, [this, &segment, self] { return !blocked(segment, self); });
+            self->second.granted = true;
+            segment.grants++;
+        });
+        if (touched > 1) spanning.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void unlock(uint64_t offset, uint64_t len, bool write) {
+        for_each_segment(offset, len, [write](Segment& segment, uint64_t begin, uint64_t end) {
+            {
+                std::lock_guard<std::mutex> guard(segment.mtx);
+                auto range = segment.index.equal_range(begin);
+                for (auto it = range.first; it != range.second; ++it) {
+                    if (it->second.end == end && it->second.write == write && it->second.granted) {
+                        segment.index.erase(it);
+                        break;
+                    }
+                }
+            }
+            segment.released.notify_all();
+        });
+    }
+
+public:
+    explicit RangeLock(uint64_t size, uint64_t segment_size = 0)
+        : total_size(std::max<uint64_t>(1, size)),
+          segment_size(segment_size > 0 ? segment_size
+                       : std::getenv("RANGE_SEGMENT") ? std::max(1ULL, std::stoull(std::getenv("RANGE_SEGMENT"))) : 4096),
+          segment_count(std::min<uint64_t>((total_size + this->segment_size - 1) / this->segment_size, MAX_SEGMENTS)),
+          segments(new Segment[segment_count]) {
+        // Very large resources keep the segment count bounded by widening the segments
+        if (segment_count == MAX_SEGMENTS) this->segment_size = (total_size + segment_count - 1) / segment_count;
+    }
+
+    void read_lock(uint64_t offset, uint64_t len) { lock(offset, len, false); }
+    void read_unlock(uint64_t offset, uint64_t len) { unlock(offset, len, false); }
+    void write_lock(uint64_t offset, uint64_t len) { lock(offset, len, true); }
+    void write_unlock(uint64_t offset, uint64_t len) { unlock(offset, len, true); }
+
+    // Whole-resource locking
+    void read_lock() { read_lock(0, total_size); }
+    void read_unlock() { read_unlock(0, total_size); }
+    void write_lock() { write_lock(0, total_size); }
+    void write_unlock() { write_unlock(0, total_size); }
+
+    uint64_t size() const {
+        return total_size;
+    }
+
+    void print_report() {
+        long long grants = 0, waits = 0;
+        for (size_t i = 0; i < segment_count; i++) {
+            std::lock_guard<std::mutex> guard(segments[i].mtx);
+            grants += segments[i].grants;
+            waits += segments[i].waits;
+        }
+        std::cout << "\n----- RANGE LOCK -----" << std::endl;
+        std::cout << "Resource: " << total_size << " bytes in " << segment_count << " segments of "
+                  << segment_size << " bytes" << std::endl;
+        std::cout << "Segment grants: " << grants << " (" << waits << " waited for an overlapping range)" << std::endl;
+        std::cout << "Requests spanning several segments: " << spanning << std::endl;
+        wait.print_report();
+    }
+};
+
+#endif // READERS_WRITERS_RANGE_H
@@ -0,0 +1,452 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_compact.h"
+#include "readers_writers_epoch.h"
+#include "readers_writers_hierarchy.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
+
+// Immutable version of the shared data, with a COW_TABLE_SIZE-entry table (default 1024)
+// standing in for a configuration or routing table
+struct Snapshot {
+    long long version = 0;
+    int data = 0;
+    std::vector<int> table;
+    
+    size_t bytes() const {
+        return sizeof(Snapshot) + table.capacity() * sizeof(int);
+    }
+};
+
+// RCU-style Readers-Writers cell
+// The current version is a plain atomic pointer. Readers enter an epoch read section
+// (one store to their own slot), load the pointer and use the version without taking a
+// reference. A writer takes the writer mutex, copies the current version, modifies the
+// copy, swaps the pointer and retires the old version; EpochDomain frees it once every
+// reader that could still see it has left its read section.
+class RcuCell {
+private:
+    std::mutex write_mtx;                       // Serialises writers; readers never take it
+    WaitStrategy wait;
+    EpochDomain domain;
+    std::atomic<Snapshot*> current;
+    long long published = 0;                    // Guarded by write_mtx
+    
+public:
+    RcuCell() {
+        int table_size = std::getenv("COW_TABLE_SIZE") ? std::stoi(std::getenv("COW_TABLE_SIZE")) : 1024;
+        Snapshot* initial = new Snapshot;
+        initial->table.assign(std::max(table_size, 1), 0);
+        current.store(initial);
+    }
+    
+    ~RcuCell() {
+        delete current.load();
+    }
+    
+    // Enter a read section and return the current version, valid until read_unlock()
+    const Snapshot* read_lock() {
+        domain.read_enter();
+        return current.load(std::memory_order_acquire);
+    }
+    
+    void read_unlock() {
+        domain.read_exit();
+    }
+    
+    // Acquire write ownership and return a private copy of the current version
+    std::unique_ptr<Snapshot> begin_write() {
+        wait.acquire([this] { return write_mtx.try_lock(); }, [this] { write_mtx.lock(); });
+        std::unique_ptr<Snapshot> next(new Snapshot(*current.load(std::memory_order_relaxed)));
+        next->version++;
+        return next;
+    }
+    
+    // Swap in the new version, retire the old one and release write ownership
+    void publish(std::unique_ptr<Snapshot> next) {
+        Snapshot* old = current.exchange(next.release(), std::memory_order_seq_cst);
+        domain.retire(old, old->bytes());
+        published++;
+        write_mtx.unlock();
+    }
+    
+    void print_wait_stats() {
+        std::cout << "\n----- RCU -----" << std::endl;
+        std::cout << "Versions published: " << published << std::endl;
+        std::cout << "Version size: " << current.load()->bytes() << " bytes" << std::endl;
+        domain.print_report();
+        wait.print_report();
+    }
+};
+
+// Uncontended read-side cost of the RCU read section against the other read paths in this
+// repository: a reference-counted shared_ptr snapshot (readers_writers_cow), std::shared_mutex,
+// and the read_lock()/read_unlock() of the lock classes that live in shared headers (the
+// compact lock and the intention lock in S mode). The writers-priority, readers-priority and
+// fair ReadersWriterLock classes are defined inside their own programs and cannot be linked
+// here, so a proxy reproduces their uncontended read path: lock the state mutex, bump the
+// reader count, unlock, and the same again on release. Every hardware thread runs
+// RCU_READ_BENCH iterations (default 1000000, 0 to skip) at the same time.
+void print_read_cost(RcuCell& cell) {
+    const long long iterations = std::getenv("RCU_READ_BENCH") ? std::stoll(std::getenv("RCU_READ_BENCH")) : 1000000;
+    if (iterations <= 0) return;
+    const int threads = std::max(1u, std::thread::hardware_concurrency());
+    
+    auto measure = [&](auto read_once) {
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&] {
+                for (long long i = 0; i < iterations; i++) read_once();
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+    };
+    
+    std::atomic<int> sink{0};
+    double rcu_ns = measure([&] {
+        const Snapshot* snapshot = cell.read_lock();
+        sink.store(snapshot->data, std::memory_order_relaxed);
+        cell.read_unlock();
+    });
+    
+    auto shared = std::make_shared<const Snapshot>();
+    double refcount_ns = measure([&] {
+        std::shared_ptr<const Snapshot> snapshot = std::atomic_load(&shared);
+        sink.store(snapshot->data, std::memory_order_relaxed);
+    });
+    
+    std::shared_mutex shared_mtx;
+    double shared_mutex_ns = measure([&] {
+        std::shared_lock<std::shared_mutex> guard(shared_mtx);
+        sink.store(1, std::memory_order_relaxed);
+    });
+    
+    // Through the shared reader/writer interface
+    auto lock_read_ns = [&](auto& lock) {
+        return measure([&] {
+            lock.read_lock();
+            sink.store(1, std::memory_order_relaxed);
+            lock.read_unlock();
+        });
+    };
+    CompactReadersWriterLock compact;
+    double compact_ns = lock_read_ns(compact);
+    IntentionLock intention;
+    double intention_ns = lock_read_ns(intention);
+    
+    // Proxy for the ReadersWriterLock family (see above)
+    std::mutex counter_mtx;
+    int active_readers = 0;
+    double counter_ns = measure([&] {
+        { std::lock_guard<std::mutex> guard(counter_mtx); active_readers++; }
+        sink.store(1, std::memory_order_relaxed);
+        { std::lock_guard<std::mutex> guard(counter_mtx); active_readers--; }
+    });
+    
+    std::cout << "\n----- READ-SIDE COST -----" << std::endl;
+    std::cout << "Threads: " << threads << ", " << iterations << " reads each (ns per read, wall time)" << std::endl;
+    std::cout << "Epoch read section: " << rcu_ns << " ns" << std::endl;
+    std::cout << "atomic shared_ptr snapshot: " << refcount_ns << " ns" << std::endl;
+    std::cout << "std::shared_mutex: " << shared_mutex_ns << " ns" << std::endl;
+    std::cout << "CompactReadersWriterLock: " << compact_ns << " ns" << std::endl;
+    std::cout << "IntentionLock (S): " << intention_ns << " ns" << std::endl;
+    std::cout << "mutex + reader count (proxy for the ReadersWriterLock family): " << counter_ns << " ns" << std::endl;
+}
+
+// Shared resource (an immutable version replaced on every write)
+class SharedResource {
+private:
+    RcuCell cell;
+    std::mutex print_mutex;  // For synchronized console output
+    
+public:
+    // Reader function: reads data from the current version
+    OpTiming reader(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " wants to read." << std::endl;
+        }
+        
+        // Enter the read section; this never waits for a writer
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        const Snapshot* snapshot = cell.read_lock();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " is reading data: " << snapshot->data
+                      << " (version " << snapshot->version << ", waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Simulate reading process; the version cannot be freed while we are in the section
+        std::this_thread::sleep_for(std::chrono::milliseconds(100 + (rand() % 900)));
+        
+        // Leave the read section
+        cell.read_unlock();
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Reader " << id << " finished reading." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Writer function: builds and publishes a new version
+    OpTiming writer(int id) {
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " wants to write." << std::endl;
+        }
+        
+        // Acquire write ownership (other writers only) and copy the current version
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
+        std::unique_ptr<Snapshot> next = cell.begin_write();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
+        
+        // Simulate writing process
+        int new_value = rand() % 1000;
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " is writing data: " << new_value
+                      << " (version " << next->version << ", waited " << wait_time << "ms)" << std::endl;
+        }
+        
+        // Modify the private copy
+        next->data = new_value;
+        next->table[next->version % next->table.size()] = new_value;
+        
+        // Simulate additional processing
+        std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
+        
+        // Publish the new version
+        cell.publish(std::move(next));
+        timing.released = std::chrono::steady_clock::now();
+        
+        {
+            std::lock_guard<std::mutex> print_lock(print_mutex);
+            std::cout << "Writer " << id << " finished writing." << std::endl;
+        }
+        
+        return timing;
+    }
+    
+    // Get the current data value
+    int get_data() {
+        int value = cell.read_lock()->data;
+        cell.read_unlock();
+        return value;
+    }
+    
+    // Print lock-internal statistics
+    void print_lock_stats() {
+        cell.print_wait_stats();
+        print_read_cost(cell);
+    }
+};
+
+// Statistics for the demonstration
+struct Statistics {
+    std::atomic<int> total_reads{0};
+    std::atomic<int> total_writes{0};
+    std::atomic<int> readers_waiting{0};
+    std::atomic<int> writers_waiting{0};
+    std::atomic<long long> reader_wait_time{0};
+    std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("RCU", num_readers, num_writers, operations_per_thread) {}
+};
+
+int main() {
+    // Seed for random number generation
+    srand(static_cast<unsigned int>(time(nullptr)));
+    
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<RcuCell>("RCU/Epoch", "RcuCell", "the current snapshot, retired versions awaiting their grace period, one 64-byte reader slot per thread");
+    }
+    
+    // Create shared resource
+    SharedResource resource;
+    
+    // Create threads for readers and writers
+    // Use environment variables if provided, otherwise use defaults
+    const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
+    const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
+    const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
+    
+    std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
+              << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
+    
+    std::vector<std::thread> threads;
+    
+    std::cout << "Starting readers-writers demonstration (RCU / EPOCH RECLAMATION) with "
+              << num_readers << " readers and " 
+              << num_writers << " writers." << std::endl;
+    
+    // Lambda to simulate reader behavior with random intervals
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to read
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.readers_waiting++;
+            OpTiming timing = resource.reader(id);
+            stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_reads++;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
+        }
+    };
+    
+    // Lambda to simulate writer behavior with random intervals
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
+        
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
+            // Random delay before attempting to write
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
+            
+            stats.writers_waiting++;
+            OpTiming timing = resource.writer(id);
+            stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
+            stats.total_writes++;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
+        }
+    };
+    
+    // Start reader threads
+    for (int i = 0; i < num_readers; i++) {
+        threads.emplace_back(reader_task, i + 1);
+    }
+    
+    // Start writer threads
+    for (int i = 0; i < num_writers; i++) {
+        threads.emplace_back(writer_task, i + 1);
+    }
+    
+    // Monitor thread for displaying statistics
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
+        int expected_operations = (num_readers + num_writers) * operations_per_thread;
+        int total_operations = 0;
+        
+        while (!run.done(total_operations, expected_operations)) {
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            total_operations = stats.total_reads + stats.total_writes;
+            
+            std::cout << "\n----- STATISTICS -----" << std::endl;
+            std::cout << "Completed reads: " << stats.total_reads << std::endl;
+            std::cout << "Completed writes: " << stats.total_writes << std::endl;
+            std::cout << "Readers waiting: " << stats.readers_waiting << std::endl;
+            std::cout << "Writers waiting: " << stats.writers_waiting << std::endl;
+            
+            // Calculate average wait times
+            float avg_reader_wait = stats.total_reads > 0 ? 
+                                     static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+            float avg_writer_wait = stats.total_writes > 0 ? 
+                                     static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+            
+            std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+            std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
+        }
+    });
+    
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
+    // Wait for all threads to complete
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    run.finish();
+    
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+    
+    std::cout << "\nDemonstration completed!" << std::endl;
+    std::cout << "Final statistics:" << std::endl;
+    std::cout << "Total reads: " << stats.total_reads << std::endl;
+    std::cout << "Total writes: " << stats.total_writes << std::endl;
+    
+    // Calculate final average wait times
+    float avg_reader_wait = stats.total_reads > 0 ? 
+                             static_cast<float>(stats.reader_wait_time) / stats.total_reads : 0;
+    float avg_writer_wait = stats.total_writes > 0 ? 
+                             static_cast<float>(stats.writer_wait_time) / stats.total_writes : 0;
+    
+    std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
+    std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
+    
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
+    return 0;
+}
@@ -6,37 +6,96 @@
 #include <vector>
 #include <random>
 #include <atomic>
+#include <map>
 #include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_handoff.h"
+#include "readers_writers_map.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
 
 // Implementation of Readers-Writers problem with readers priority
 // This approach favors readers, potentially leading to writer starvation
+//
+// Optionally the starvation can be bounded: every reader admitted while a writer waits
+// counts as a bypass of the oldest waiting writer, and once BYPASS_LIMIT bypasses or
+// BYPASS_BUDGET_MS of waiting are exceeded new readers are held back until that writer
+// has been served. Without either variable the lock is purely reader-preferring.
 class ReadersWriterLock {
 private:
-    std::mutex mtx;                // Protects access to reader_count
-    std::mutex resource_mutex;     // Provides exclusive access to the resource
+    // Exclusion follows from the state below alone: a writer only becomes active when
+    // reader_count is 0, and readers only enter while no writer is active
+    std::mutex mtx;                // Protects the lock state
     std::condition_variable reader_cv; // Condition variable for readers
     std::condition_variable writer_cv; // Condition variable for writers
     
     int reader_count = 0;          // Number of active readers
     bool writer_active = false;    // Flag to check if writer is active
     
+    // Bounded bypass
+    int bypass_limit;                             // 0 = unlimited
+    std::chrono::milliseconds bypass_budget;      // 0 = unlimited
+    std::map<long long, std::chrono::steady_clock::time_point> waiting_writers; // Ticket -> arrival
+    long long next_writer_ticket = 0;
+    int bypasses = 0;              // Readers admitted past the current oldest writer
+    bool draining = false;         // New readers wait until the oldest writer is served
+    long long total_bypasses = 0;  // Diagnostics
+    long long drain_phases = 0;
+    std::chrono::steady_clock::duration longest_writer_wait{0};
+    
+    WaitStrategy wait;             // Spin-then-park policy for blocked threads
+    ResourceGate gate;             // Old second resource lock, only with RESOURCE_GATE=1
+    
+    static long long env_or(const char* name, long long fallback) {
+        return std::getenv(name) ? std::stoll(std::getenv(name)) : fallback;
+    }
+    
+    bool bounded() const {
+        return bypass_limit > 0 || bypass_budget.count() > 0;
+    }
+    
+    // Switch to draining once the oldest waiting writer has been bypassed enough. A
+    // notify_one from before the switch may have woken a younger writer, which now goes
+    // back to sleep, so every writer is woken to make sure the oldest one re-checks
+    void check_bypass_bound() {
+        if (!bounded() || draining || waiting_writers.empty()) return;
+        auto waited = std::chrono::steady_clock::now() - waiting_writers.begin()->second;
+        if ((bypass_limit > 0 && bypasses >= bypass_limit) ||
+            (bypass_budget.count() > 0 && waited >= bypass_budget)) {
+            draining = true;
+            drain_phases++;
+            writer_cv.notify_all();
+        }
+    }
+    
 public:
+    ReadersWriterLock()
+        : bypass_limit(static_cast<int>(env_or("BYPASS_LIMIT", 0))),
+          bypass_budget(env_or("BYPASS_BUDGET_MS", 0)) {}
+    
     // Reader tries to acquire the lock - readers have priority
     void read_lock() {
         std::unique_lock<std::mutex> lock(mtx);
         
-        // Readers only wait if there's an active writer
+        // Readers only wait if there's an active writer (or the bypass bound was hit)
         // Note: readers don't check for waiting writers, giving them priority
-        reader_cv.wait(lock, [this] { 
-            return !writer_active; 
+        check_bypass_bound();
+        wait.wait(lock, reader_cv, [this] { 
+            return !writer_active && !draining; 
         });
         
         // Increment the reader count
         reader_count++;
-        
-        // First reader acquires the resource lock
-        if (reader_count == 1) {
-            resource_mutex.lock();
+        if (reader_count == 1) gate.acquire();
+        
+        // Entering while a writer waits overtakes that writer. Re-check the bound at once:
+        // readers woken together by notify_all enter one after another, and the next one
+        // must already see the drain
+        if (!waiting_writers.empty()) {
+            bypasses++;
+            total_bypasses++;
+            check_bypass_bound();
         }
         
         lock.unlock();
@@ -48,11 +107,16 @@ public:
         
         // Decrement the reader count
         reader_count--;
+        if (reader_count == 0) gate.release();
         
-        // Last reader releases the resource lock and notifies waiting writers
+        // Last reader notifies waiting writers; while draining only the oldest may enter,
+        // so all of them are woken to find it
         if (reader_count == 0) {
-            resource_mutex.unlock();
-            writer_cv.notify_one(); // Notify a single waiting writer
+            if (draining) {
+                writer_cv.notify_all();
+            } else {
+                writer_cv.notify_one(); // Notify a single waiting writer
+            }
         }
         
         lock.unlock();
@@ -62,18 +126,29 @@ public:
     void write_lock() {
         std::unique_lock<std::mutex> lock(mtx);
         
+        long long ticket = next_writer_ticket++;
+        auto arrived = std::chrono::steady_clock::now();
+        waiting_writers[ticket] = arrived;
+        
         // Wait until there are no active readers and no active writers
-        writer_cv.wait(lock, [this] { 
-            return reader_count == 0 && !writer_active; 
+        wait.wait(lock, writer_cv, [this, ticket] { 
+            return reader_count == 0 && !writer_active &&
+                   (!draining || ticket == waiting_writers.begin()->first); 
         });
         
+        // Serving the oldest writer ends the drain and restarts the bypass count
+        if (ticket == waiting_writers.begin()->first) {
+            draining = false;
+            bypasses = 0;
+        }
+        waiting_writers.erase(ticket);
+        longest_writer_wait = std::max(longest_writer_wait, std::chrono::steady_clock::now() - arrived);
+        
         // Mark writer as active
         writer_active = true;
         
         lock.unlock();
-        
-        // Acquire exclusive access to the resource
-        resource_mutex.lock();
+        gate.acquire();
     }
     
     // Writer releases the lock
@@ -82,16 +157,34 @@ public:
         
         // Mark writer as inactive
         writer_active = false;
+        check_bypass_bound();
+        bool targeted = draining;
         
         lock.unlock();
-        
-        // Release exclusive access to the resource
-        resource_mutex.unlock();
+        gate.release();
         
         // Notify all waiting readers first, giving them priority
         reader_cv.notify_all();
-        // Then notify one waiting writer
-        writer_cv.notify_one();
+        // Then notify one waiting writer (all of them if only the oldest may enter)
+        if (targeted) {
+            writer_cv.notify_all();
+        } else {
+            writer_cv.notify_one();
+        }
+    }
+    
+    // Print how the waits were resolved
+    void print_wait_stats() const {
+        if (bounded()) {
+            std::cout << "\n----- WRITER BYPASS BOUND -----" << std::endl;
+            std::cout << "Bypass limit: " << bypass_limit << " readers, " << bypass_budget.count()
+                      << " ms (0 = unlimited)" << std::endl;
+            std::cout << "Readers admitted past a waiting writer: " << total_bypasses << std::endl;
+            std::cout << "Drain phases: " << drain_phases << std::endl;
+            std::cout << "Longest writer wait in the lock: "
+                      << std::chrono::duration<double, std::milli>(longest_writer_wait).count() << " ms" << std::endl;
+        }
+        wait.print_report();
     }
 };
 
@@ -104,17 +197,18 @@ private:
     
 public:
     // Reader function: reads data from the shared resource
-    long long reader(int id) {
+    OpTiming reader(int id) {
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Reader " << id << " wants to read." << std::endl;
         }
         
         // Acquire read lock
-        auto start_time = std::chrono::steady_clock::now();
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         rwlock.read_lock();
-        auto end_time = std::chrono::steady_clock::now();
-        auto wait_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
@@ -127,27 +221,29 @@ public:
         
         // Release read lock
         rwlock.read_unlock();
+        timing.released = std::chrono::steady_clock::now();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Reader " << id << " finished reading." << std::endl;
         }
         
-        return wait_time;
+        return timing;
     }
     
     // Writer function: modifies the shared resource
-    int writer(int id) {
+    OpTiming writer(int id) {
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Writer " << id << " wants to write." << std::endl;
         }
         
         // Acquire write lock
-        auto start_time = std::chrono::steady_clock::now();
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         rwlock.write_lock();
-        auto end_time = std::chrono::steady_clock::now();
-        auto wait_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
         
         // Simulate writing process
         int new_value = rand() % 1000;
@@ -166,19 +262,25 @@ public:
         
         // Release write lock
         rwlock.write_unlock();
+        timing.released = std::chrono::steady_clock::now();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Writer " << id << " finished writing." << std::endl;
         }
         
-        return wait_time;
+        return timing;
     }
     
     // Get the current data value
     int get_data() const {
         return data;
     }
+    
+    // Print lock-internal statistics
+    void print_lock_stats() const {
+        rwlock.print_wait_stats();
+    }
 };
 
 // Statistics for the demonstration
@@ -189,24 +291,51 @@ struct Statistics {
     std::atomic<int> writers_waiting{0};
     std::atomic<long long> reader_wait_time{0};
     std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("Readers-Priority", num_readers, num_writers, operations_per_thread) {}
 };
 
 int main() {
     // Seed for random number generation
     srand(static_cast<unsigned int>(time(nullptr)));
     
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<ReadersWriterLock>("Readers-Priority", "ReadersWriterLock");
+    }
+    
+    // WORKLOAD=map benchmarks a striped hash map built on this lock instead
+    if (map_workload_requested()) {
+        return run_map_benchmark<ReadersWriterLock>("Readers-Priority");
+    }
+    
+    // WORKLOAD=handoff measures reader-to-writer handoff latency (RESOURCE_GATE=1: old protocol)
+    if (handoff_workload_requested()) {
+        return run_handoff_benchmark<ReadersWriterLock>("Readers-Priority");
+    }
+    
     // Create shared resource
     SharedResource resource;
-    Statistics stats;
     
     // Create threads for readers and writers
     // Use environment variables if provided, otherwise use defaults
     const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
     const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
     const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
     
     std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
               << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
     
     std::vector<std::thread> threads;
     
@@ -215,38 +344,62 @@ int main() {
               << num_writers << " writers." << std::endl;
     
     // Lambda to simulate reader behavior with random intervals
-    auto reader_task = [&resource, &stats, operations_per_thread](int id) {
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
         
-        for (int i = 0; i < operations_per_thread; i++) {
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
             // Random delay before attempting to read
             std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
             
             stats.readers_waiting++;
-            long long wait_time = resource.reader(id);
+            OpTiming timing = resource.reader(id);
             stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
             stats.total_reads++;
-            stats.reader_wait_time += wait_time;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
         }
     };
     
     // Lambda to simulate writer behavior with random intervals
-    auto writer_task = [&resource, &stats, operations_per_thread](int id) {
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
         
-        for (int i = 0; i < operations_per_thread; i++) {
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
             // Random delay before attempting to write
             std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
             
             stats.writers_waiting++;
-            long long wait_time = resource.writer(id);
+            OpTiming timing = resource.writer(id);
             stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
             stats.total_writes++;
-            stats.writer_wait_time += wait_time;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
         }
     };
     
@@ -261,11 +414,11 @@ int main() {
     }
     
     // Monitor thread for displaying statistics
-    std::thread monitor([&stats, num_readers, num_writers, operations_per_thread]() {
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
         int expected_operations = (num_readers + num_writers) * operations_per_thread;
         int total_operations = 0;
         
-        while (total_operations < expected_operations) {
+        while (!run.done(total_operations, expected_operations)) {
             std::this_thread::sleep_for(std::chrono::seconds(2));
             total_operations = stats.total_reads + stats.total_writes;
             
@@ -283,16 +436,20 @@ int main() {
             
             std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
             std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
-            std::cout << "Progress: " << (total_operations * 100) / expected_operations << "%" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
         }
     });
     
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
     // Wait for all threads to complete
     for (auto& thread : threads) {
         if (thread.joinable()) {
             thread.join();
         }
     }
+    run.finish();
     
     if (monitor.joinable()) {
         monitor.join();
@@ -312,5 +469,11 @@ int main() {
     std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
     std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
     
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
     return 0;
 }
@@ -6,6 +6,11 @@
 #include <atomic>
 #include <semaphore.h>
 #include <mutex>
+#include "readers_writers_bench.h"
+#include "readers_writers_map.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
 
 // This implementation uses POSIX semaphores for synchronization
 class ReadersWriterSemaphore {
@@ -14,11 +19,17 @@ private:
     sem_t write_mutex;     // For exclusive writer access
     sem_t read_mutex;      // To block readers when writers are waiting
     int reader_count;      // Number of active readers
-    bool writer_waiting;   // Flag to indicate if writers are waiting
+    std::atomic<int> writers_waiting; // Writers waiting for write_mutex (not guarded by mutex)
     std::mutex print_mutex; // For synchronized console output
+    WaitStrategy wait;     // Spin on sem_trywait before blocking in sem_wait
+
+    // sem_wait with the spin-then-park wait strategy
+    void acquire(sem_t* sem) {
+        wait.acquire([sem] { return sem_trywait(sem) == 0; }, [sem] { while (sem_wait(sem) != 0) {} });
+    }
 
 public:
-    ReadersWriterSemaphore() : reader_count(0), writer_waiting(false) {
+    ReadersWriterSemaphore() : reader_count(0), writers_waiting(0) {
         // Initialize semaphores
         sem_init(&mutex, 0, 1);       // Binary semaphore
         sem_init(&write_mutex, 0, 1); // Binary semaphore
@@ -34,18 +45,15 @@ public:
 
     // Writer attempts to acquire lock
     void writer_lock() {
-        // Signal that a writer is waiting
-        sem_wait(&mutex);
-        writer_waiting = true;
-        sem_post(&mutex);
+        // Signal that a writer is waiting. This must not take `mutex`: the first reader
+        // holds it while blocked on write_mutex, so a writer that owns write_mutex and
+        // then waits for `mutex` would deadlock with that reader.
+        writers_waiting++;
         
         // Wait for exclusive access to the resource
-        sem_wait(&write_mutex);
+        acquire(&write_mutex);
         
-        // Reset writer waiting flag
-        sem_wait(&mutex);
-        writer_waiting = false;
-        sem_post(&mutex);
+        writers_waiting--;
     }
 
     // Writer releases lock
@@ -56,17 +64,17 @@ public:
     // Reader attempts to acquire lock
     void reader_lock() {
         // Check if writers are waiting
-        sem_wait(&read_mutex);
+        acquire(&read_mutex);
         
-        sem_wait(&mutex);
-        bool should_wait = writer_waiting;
+        acquire(&mutex);
+        bool should_wait = writers_waiting > 0;
         
         if (!should_wait) {
             reader_count++;
             
             // First reader acquires write lock
             if (reader_count == 1) {
-                sem_wait(&write_mutex);
+                acquire(&write_mutex);
             }
         }
         
@@ -83,7 +91,7 @@ public:
 
     // Reader releases lock
     void reader_unlock() {
-        sem_wait(&mutex);
+        acquire(&mutex);
         reader_count--;
         
         // Last reader releases write lock
@@ -99,6 +107,19 @@ public:
         std::lock_guard<std::mutex> lock(print_mutex);
         std::cout << message << std::endl;
     }
+    
+    // Print how the waits were resolved
+    void print_wait_stats() const {
+        wait.print_report();
+    }
+};
+
+// The read_lock()/write_lock() interface expected by readers_writers_map.h
+struct SemaphoreLockAdapter : ReadersWriterSemaphore {
+    void read_lock() { reader_lock(); }
+    void read_unlock() { reader_unlock(); }
+    void write_lock() { writer_lock(); }
+    void write_unlock() { writer_unlock(); }
 };
 
 // Shared resource (simulated as an integer)
@@ -111,11 +132,14 @@ public:
     SharedData() : data(0) {}
     
     // Reader function
-    void reader(int id) {
+    OpTiming reader(int id) {
         std::string start_msg = "Reader " + std::to_string(id) + " wants to read.";
         rwlock.print_status(start_msg);
         
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         rwlock.reader_lock();
+        timing.granted = std::chrono::steady_clock::now();
         
         std::string reading_msg = "Reader " + std::to_string(id) + " reading data: " + std::to_string(data);
         rwlock.print_status(reading_msg);
@@ -124,17 +148,23 @@ public:
         std::this_thread::sleep_for(std::chrono::milliseconds(100 + (rand() % 900)));
         
         rwlock.reader_unlock();
+        timing.released = std::chrono::steady_clock::now();
         
         std::string end_msg = "Reader " + std::to_string(id) + " finished reading.";
         rwlock.print_status(end_msg);
+        
+        return timing;
     }
     
     // Writer function
-    void writer(int id) {
+    OpTiming writer(int id) {
         std::string start_msg = "Writer " + std::to_string(id) + " wants to write.";
         rwlock.print_status(start_msg);
         
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         rwlock.writer_lock();
+        timing.granted = std::chrono::steady_clock::now();
         
         // Generate a new value and update data
         int new_value = rand() % 1000;
@@ -147,9 +177,17 @@ public:
         std::this_thread::sleep_for(std::chrono::milliseconds(200 + (rand() % 800)));
         
         rwlock.writer_unlock();
+        timing.released = std::chrono::steady_clock::now();
         
         std::string end_msg = "Writer " + std::to_string(id) + " finished writing.";
         rwlock.print_status(end_msg);
+        
+        return timing;
+    }
+    
+    // Print lock-internal statistics
+    void print_lock_stats() const {
+        rwlock.print_wait_stats();
     }
 };
 
@@ -157,24 +195,46 @@ public:
 struct Stats {
     std::atomic<int> total_reads{0};
     std::atomic<int> total_writes{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Stats(int num_readers, int num_writers, int ops_per_thread)
+        : fairness(num_readers, num_writers, ops_per_thread),
+          trace("Semaphore-based", num_readers, num_writers, ops_per_thread) {}
 };
 
 int main() {
     // Seed for random number generation
     srand(static_cast<unsigned int>(time(nullptr)));
     
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<ReadersWriterSemaphore>("Semaphore-based", "ReadersWriterSemaphore");
+    }
+    
+    // WORKLOAD=map benchmarks a striped hash map built on this lock instead
+    if (map_workload_requested()) {
+        return run_map_benchmark<SemaphoreLockAdapter>("Semaphore-based");
+    }
+    
     // Create shared resource
     SharedData resource;
-    Stats stats;
     
     // Create threads for readers and writers
     // Use environment variables if provided, otherwise use defaults
     const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 8;
     const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 4;
     const int ops_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 3;
+    Stats stats(num_readers, num_writers, ops_per_thread);
+    BenchmarkRun run(num_readers + num_writers, ops_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
     
     std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
               << " writers, " << ops_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
     
     std::cout << "Starting semaphore-based readers-writers demonstration with "
               << num_readers << " readers and " 
@@ -184,45 +244,75 @@ int main() {
     
     // Create reader threads
     for (int i = 0; i < num_readers; i++) {
-        threads.emplace_back([&resource, &stats, i, ops_per_thread]() {
+        threads.emplace_back([&resource, &stats, &run, &placement, i]() {
             std::random_device rd;
             std::mt19937 gen(rd());
             std::uniform_int_distribution<> delay_dist(100, 1000);
             
-            for (int j = 0; j < ops_per_thread; j++) {
+            placement.pin_reader(i + 1);
+            run.wait_for_start();
+            
+            for (int j = 0; run.keep_running(j); j++) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
-                resource.reader(i + 1);
+                if (run.stopped()) break;
+                
+                OpTiming timing = resource.reader(i + 1);
+                stats.trace.record_read(i + 1, timing);
+                
+                // Only operations that complete inside the measurement window count
+                if (!run.in_window(timing)) continue;
                 stats.total_reads++;
+                stats.fairness.record_read(i + 1, timing);
             }
         });
     }
     
     // Create writer threads
     for (int i = 0; i < num_writers; i++) {
-        threads.emplace_back([&resource, &stats, i, ops_per_thread]() {
+        threads.emplace_back([&resource, &stats, &run, &placement, i]() {
             std::random_device rd;
             std::mt19937 gen(rd());
             std::uniform_int_distribution<> delay_dist(200, 1500);
             
-            for (int j = 0; j < ops_per_thread; j++) {
+            placement.pin_writer(i + 1);
+            run.wait_for_start();
+            
+            for (int j = 0; run.keep_running(j); j++) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
-                resource.writer(i + 1);
+                if (run.stopped()) break;
+                
+                OpTiming timing = resource.writer(i + 1);
+                stats.trace.record_write(i + 1, timing);
+                
+                // Only operations that complete inside the measurement window count
+                if (!run.in_window(timing)) continue;
                 stats.total_writes++;
+                stats.fairness.record_write(i + 1, timing);
             }
         });
     }
     
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
     // Wait for all threads to complete
     for (auto& thread : threads) {
         if (thread.joinable()) {
             thread.join();
         }
     }
+    run.finish();
     
     std::cout << "\nDemonstration completed!" << std::endl;
     std::cout << "Final statistics:" << std::endl;
     std::cout << "Total reads: " << stats.total_reads << std::endl;
     std::cout << "Total writes: " << stats.total_writes << std::endl;
     
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
     return 0;
 }
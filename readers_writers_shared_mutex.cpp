@@ -6,6 +6,11 @@
 #include <random>
 #include <atomic>
 #include <cstdlib> // For getenv, stoi
+#include "readers_writers_bench.h"
+#include "readers_writers_map.h"
+#include "readers_writers_topology.h"
+#include "readers_writers_trace.h"
+#include "readers_writers_wait.h"
 
 // Implementation of Readers-Writers problem using C++17's std::shared_mutex
 // This approach uses the standard library's built-in read-write lock
@@ -13,11 +18,12 @@ class ReadersWriterLock {
 private:
     std::shared_mutex rwmutex;     // C++17 shared mutex for read-write locks
     std::mutex print_mutex;        // For synchronized console output
+    WaitStrategy wait;             // Spin on try_lock before blocking in the shared_mutex
     
 public:
     // Reader tries to acquire the lock
     void read_lock() {
-        rwmutex.lock_shared();
+        wait.acquire([this] { return rwmutex.try_lock_shared(); }, [this] { rwmutex.lock_shared(); });
     }
     
     // Reader releases the lock
@@ -27,7 +33,7 @@ public:
     
     // Writer tries to acquire the lock
     void write_lock() {
-        rwmutex.lock();
+        wait.acquire([this] { return rwmutex.try_lock(); }, [this] { rwmutex.lock(); });
     }
     
     // Writer releases the lock
@@ -40,6 +46,11 @@ public:
         std::lock_guard<std::mutex> lock(print_mutex);
         std::cout << message << std::endl;
     }
+    
+    // Print how the waits were resolved
+    void print_wait_stats() const {
+        wait.print_report();
+    }
 };
 
 // Shared resource (simulated as an integer)
@@ -51,17 +62,18 @@ private:
     
 public:
     // Reader function: reads data from the shared resource
-    int reader(int id) {
+    OpTiming reader(int id) {
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Reader " << id << " wants to read." << std::endl;
         }
         
         // Acquire read lock
-        auto start_time = std::chrono::steady_clock::now();
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         rwlock.read_lock();
-        auto end_time = std::chrono::steady_clock::now();
-        auto wait_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
@@ -74,27 +86,29 @@ public:
         
         // Release read lock
         rwlock.read_unlock();
+        timing.released = std::chrono::steady_clock::now();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Reader " << id << " finished reading." << std::endl;
         }
         
-        return wait_time;
+        return timing;
     }
     
     // Writer function: modifies the shared resource
-    int writer(int id) {
+    OpTiming writer(int id) {
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Writer " << id << " wants to write." << std::endl;
         }
         
         // Acquire write lock
-        auto start_time = std::chrono::steady_clock::now();
+        OpTiming timing;
+        timing.requested = std::chrono::steady_clock::now();
         rwlock.write_lock();
-        auto end_time = std::chrono::steady_clock::now();
-        auto wait_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        timing.granted = std::chrono::steady_clock::now();
+        auto wait_time = timing.wait_ms();
         
         // Simulate writing process
         int new_value = rand() % 1000;
@@ -113,19 +127,25 @@ public:
         
         // Release write lock
         rwlock.write_unlock();
+        timing.released = std::chrono::steady_clock::now();
         
         {
             std::lock_guard<std::mutex> print_lock(print_mutex);
             std::cout << "Writer " << id << " finished writing." << std::endl;
         }
         
-        return wait_time;
+        return timing;
     }
     
     // Get the current data value
     int get_data() const {
         return data;
     }
+    
+    // Print lock-internal statistics
+    void print_lock_stats() const {
+        rwlock.print_wait_stats();
+    }
 };
 
 // Statistics for the demonstration
@@ -136,24 +156,46 @@ struct Statistics {
     std::atomic<int> writers_waiting{0};
     std::atomic<long long> reader_wait_time{0};
     std::atomic<long long> writer_wait_time{0};
+    FairnessTracker fairness;
+    TraceRecorder trace;
+    
+    Statistics(int num_readers, int num_writers, int operations_per_thread)
+        : fairness(num_readers, num_writers, operations_per_thread),
+          trace("std::shared_mutex", num_readers, num_writers, operations_per_thread) {}
 };
 
 int main() {
     // Seed for random number generation
     srand(static_cast<unsigned int>(time(nullptr)));
     
+    // WORKLOAD=sizes only reports how much memory this lock takes
+    if (footprint_requested()) {
+        return print_lock_footprint<ReadersWriterLock>("std::shared_mutex", "ReadersWriterLock");
+    }
+    
+    // WORKLOAD=map benchmarks a striped hash map built on this lock instead
+    if (map_workload_requested()) {
+        return run_map_benchmark<ReadersWriterLock>("std::shared_mutex");
+    }
+    
     // Create shared resource
     SharedResource resource;
-    Statistics stats;
     
     // Create threads for readers and writers
     // Use environment variables if provided, otherwise use defaults
     const int num_readers = std::getenv("READERS") ? std::stoi(std::getenv("READERS")) : 10;
     const int num_writers = std::getenv("WRITERS") ? std::stoi(std::getenv("WRITERS")) : 5;
     const int operations_per_thread = std::getenv("OPERATIONS") ? std::stoi(std::getenv("OPERATIONS")) : 5;
+    Statistics stats(num_readers, num_writers, operations_per_thread);
+    BenchmarkRun run(num_readers + num_writers, operations_per_thread);
+    CpuTopology topology;
+    ThreadPlacement placement(topology, num_readers, num_writers);
     
     std::cout << "Configuration: " << num_readers << " readers, " << num_writers 
               << " writers, " << operations_per_thread << " operations per thread" << std::endl;
+    run.print_configuration();
+    topology.print_summary();
+    placement.print_summary();
     
     std::vector<std::thread> threads;
     
@@ -162,38 +204,62 @@ int main() {
               << num_writers << " writers." << std::endl;
     
     // Lambda to simulate reader behavior with random intervals
-    auto reader_task = [&resource, &stats, operations_per_thread](int id) {
+    auto reader_task = [&resource, &stats, &run, &placement](int id) {
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_int_distribution<> delay_dist(100, 1000);  // 100-1000ms delay
         
-        for (int i = 0; i < operations_per_thread; i++) {
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_reader(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
             // Random delay before attempting to read
             std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
             
             stats.readers_waiting++;
-            long long wait_time = resource.reader(id);
+            OpTiming timing = resource.reader(id);
             stats.readers_waiting--;
+            stats.trace.record_read(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
             stats.total_reads++;
-            stats.reader_wait_time += wait_time;
+            stats.reader_wait_time += timing.wait_ms();
+            stats.fairness.record_read(id, timing);
         }
     };
     
     // Lambda to simulate writer behavior with random intervals
-    auto writer_task = [&resource, &stats, operations_per_thread](int id) {
+    auto writer_task = [&resource, &stats, &run, &placement](int id) {
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_int_distribution<> delay_dist(200, 1500);  // 200-1500ms delay
         
-        for (int i = 0; i < operations_per_thread; i++) {
+        // Pin to the CPU chosen by the PLACEMENT policy (no-op by default)
+        placement.pin_writer(id);
+        
+        // Wait at the start barrier so that every thread begins under full contention
+        run.wait_for_start();
+        
+        for (int i = 0; run.keep_running(i); i++) {
             // Random delay before attempting to write
             std::this_thread::sleep_for(std::chrono::milliseconds(delay_dist(gen)));
+            if (run.stopped()) break;
             
             stats.writers_waiting++;
-            long long wait_time = resource.writer(id);
+            OpTiming timing = resource.writer(id);
             stats.writers_waiting--;
+            stats.trace.record_write(id, timing);
+            
+            // Only operations that complete inside the measurement window count
+            if (!run.in_window(timing)) continue;
             stats.total_writes++;
-            stats.writer_wait_time += wait_time;
+            stats.writer_wait_time += timing.wait_ms();
+            stats.fairness.record_write(id, timing);
         }
     };
     
@@ -208,11 +274,11 @@ int main() {
     }
     
     // Monitor thread for displaying statistics
-    std::thread monitor([&stats, num_readers, num_writers, operations_per_thread]() {
+    std::thread monitor([&stats, &run, num_readers, num_writers, operations_per_thread]() {
         int expected_operations = (num_readers + num_writers) * operations_per_thread;
         int total_operations = 0;
         
-        while (total_operations < expected_operations) {
+        while (!run.done(total_operations, expected_operations)) {
             std::this_thread::sleep_for(std::chrono::seconds(2));
             total_operations = stats.total_reads + stats.total_writes;
             
@@ -230,16 +296,20 @@ int main() {
             
             std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
             std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
-            std::cout << "Progress: " << (total_operations * 100) / expected_operations << "%" << std::endl;
+            std::cout << "Progress: " << run.progress_percent(total_operations, expected_operations) << "%" << std::endl;
         }
     });
     
+    // Release the start barrier; in timed mode this also runs warm-up and the measurement window
+    run.start();
+    
     // Wait for all threads to complete
     for (auto& thread : threads) {
         if (thread.joinable()) {
             thread.join();
         }
     }
+    run.finish();
     
     if (monitor.joinable()) {
         monitor.join();
@@ -259,5 +329,11 @@ int main() {
     std::cout << "Avg reader wait time: " << avg_reader_wait << " ms" << std::endl;
     std::cout << "Avg writer wait time: " << avg_writer_wait << " ms" << std::endl;
     
+    run.print_report(stats.total_reads, stats.total_writes);
+    placement.print_pin_report();
+    stats.fairness.print_report();
+    resource.print_lock_stats();
+    stats.trace.write();
+    
     return 0;
 }
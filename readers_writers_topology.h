@@ -0,0 +1,314 @@
+/**
+ * readers_writers_topology.h - CPU topology discovery and thread placement for the demos
+ *
+ * Lock handoff cost depends on whether the two threads share an SMT core, a socket or
+ * nothing at all, so free-floating threads make results hard to compare between runs.
+ * CpuTopology reads /sys/devices/system/cpu and ThreadPlacement pins every reader and
+ * writer according to the PLACEMENT policy:
+ *
+ *   PLACEMENT=none      Threads float freely (default)
+ *   PLACEMENT=compact   Fill SMT siblings, then cores, then sockets
+ *   PLACEMENT=scatter   Spread across sockets first, then cores, then SMT siblings
+ *   PLACEMENT=physical  One thread per physical core (first SMT sibling only)
+ *   PLACEMENT=list      Explicit lists: READER_CPUS / WRITER_CPUS (or CPUS for both),
+ *                       e.g. CPUS=0,2,4-7
+ *
+ * When there are more threads than CPUs in the chosen order, assignments wrap around.
+ */
+
+#ifndef READERS_WRITERS_TOPOLOGY_H
+#define READERS_WRITERS_TOPOLOGY_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Parse a kernel CPU list such as "0-3,8,10-11"
+inline std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// Format a CPU assignment; unpinned slots (-1) are shown as "*"
+inline std::string format_cpu_list(const std::vector<int>& cpus) {
+    std::string text;
+    for (size_t i = 0; i < cpus.size(); i++) {
+        if (i > 0) text += ",";
+        text += cpus[i] >= 0 ? std::to_string(cpus[i]) : "*";
+    }
+    return text;
+}
+
+class CpuTopology {
+public:
+    struct Cpu {
+        int id;
+        int core;       // Physical core id, unique within a socket
+        int socket;     // physical_package_id
+        int node;       // NUMA node (0 when the machine has no NUMA information)
+        int smt_index;  // Position among the SMT siblings of its core
+    };
+
+private:
+    std::vector<Cpu> cpus;
+    bool from_sysfs = false;
+
+    static bool read_line(const std::string& path, std::string& line) {
+        std::ifstream in(path);
+        return static_cast<bool>(std::getline(in, line));
+    }
+
+    static int read_int(const std::string& path, int fallback) {
+        std::string line;
+        return read_line(path, line) ? std::stoi(line) : fallback;
+    }
+
+    void discover() {
+        const std::string root = "/sys/devices/system/cpu/";
+        std::string online;
+        if (!read_line(root + "online", online)) {
+            // No sysfs: assume one socket of independent cores
+            int count = std::max(1u, std::thread::hardware_concurrency());
+            for (int i = 0; i < count; i++) cpus.push_back({i, i, 0, 0, 0});
+            return;
+        }
+        from_sysfs = true;
+
+        for (int id : parse_cpu_list(online)) {
+            std::string topo = root + "cpu" + std::to_string(id) + "/topology/";
+            Cpu cpu{id, read_int(topo + "core_id", id), read_int(topo + "physical_package_id", 0), 0, 0};
+            if (cpu.socket < 0) cpu.socket = 0;
+
+            std::string siblings;
+            if (read_line(topo + "thread_siblings_list", siblings)) {
+                std::vector<int> list = parse_cpu_list(siblings);
+                cpu.smt_index = std::find(list.begin(), list.end(), id) - list.begin();
+            }
+            cpus.push_back(cpu);
+        }
+
+        // NUMA nodes list their CPUs; machines without NUMA simply have no node directories
+        std::string nodes;
+        if (read_line("/sys/devices/system/node/online", nodes)) {
+            for (int node : parse_cpu_list(nodes)) {
+                std::string cpulist;
+                if (!read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", cpulist)) continue;
+                for (int id : parse_cpu_list(cpulist)) {
+                    for (auto& cpu : cpus) {
+                        if (cpu.id == id) cpu.node = node;
+                    }
+                }
+            }
+        }
+    }
+
+    template <typename Key>
+    std::vector<int> ordered_by(Key key) const {
+        std::vector<Cpu> sorted = cpus;
+        std::sort(sorted.begin(), sorted.end(), [&](const Cpu& a, const Cpu& b) { return key(a) < key(b); });
+        std::vector<int> ids;
+        for (const auto& cpu : sorted) ids.push_back(cpu.id);
+        return ids;
+    }
+
+    template <typename Field>
+    int count_distinct(Field field) const {
+        std::set<std::pair<int, int>> seen;
+        for (const auto& cpu : cpus) seen.insert(field(cpu));
+        return seen.size();
+    }
+
+public:
+    CpuTopology() {
+        discover();
+    }
+
+    const std::vector<Cpu>& all() const {
+        return cpus;
+    }
+
+    int cpu_count() const {
+        return cpus.size();
+    }
+
+    int socket_count() const {
+        return count_distinct([](const Cpu& c) { return std::make_pair(c.socket, 0); });
+    }
+
+    int core_count() const {
+        return count_distinct([](const Cpu& c) { return std::make_pair(c.socket, c.core); });
+    }
+
+    int node_count() const {
+        return count_distinct([](const Cpu& c) { return std::make_pair(c.node, 0); });
+    }
+
+    // NUMA node of a CPU, or 0 if unknown
+    int node_of(int cpu_id) const {
+        for (const auto& cpu : cpus) {
+            if (cpu.id == cpu_id) return cpu.node;
+        }
+        return 0;
+    }
+
+    // SMT siblings first, then the next core of the same socket, then the next socket
+    std::vector<int> compact_order() const {
+        return ordered_by([](const Cpu& c) { return std::make_tuple(c.socket, c.core, c.smt_index, c.id); });
+    }
+
+    // Alternate sockets first, then cores, and only then SMT siblings
+    std::vector<int> scatter_order() const {
+        // Rank each core within its socket so cores of different sockets interleave
+        std::vector<std::pair<int, int>> cores;
+        for (const auto& c : cpus) cores.push_back({c.socket, c.core});
+        std::sort(cores.begin(), cores.end());
+        cores.erase(std::unique(cores.begin(), cores.end()), cores.end());
+        auto core_rank = [&](const Cpu& c) {
+            int rank = 0;
+            for (const auto& core : cores) {
+                if (core == std::make_pair(c.socket, c.core)) break;
+                if (core.first == c.socket) rank++;
+            }
+            return rank;
+        };
+        return ordered_by([&](const Cpu& c) { return std::make_tuple(c.smt_index, core_rank(c), c.socket, c.id); });
+    }
+
+    // First SMT sibling of every physical core
+    std::vector<int> physical_core_order() const {
+        std::vector<int> ids;
+        for (int id : scatter_order()) {
+            for (const auto& cpu : cpus) {
+                if (cpu.id == id && cpu.smt_index == 0) ids.push_back(id);
+            }
+        }
+        return ids;
+    }
+
+    void print_summary() const {
+        std::cout << "Topology: " << socket_count() << " socket(s), " << core_count() << " core(s), "
+                  << cpu_count() << " CPU(s), " << node_count() << " NUMA node(s)"
+                  << (from_sysfs ? "" : " (sysfs unavailable, assumed flat)") << std::endl;
+    }
+};
+
+class ThreadPlacement {
+private:
+    std::string policy;
+    std::vector<int> reader_cpus;   // CPU for reader i (index 0-based), empty if not pinned
+    std::vector<int> writer_cpus;
+    mutable std::atomic<int> pin_attempts{0};
+    mutable std::atomic<int> pin_failures{0};  // Those threads ran unpinned
+
+    static std::string env_or(const char* name, const std::string& fallback) {
+        return std::getenv(name) ? std::getenv(name) : fallback;
+    }
+
+    static bool pin_current_thread(int cpu) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+    static void assign(std::vector<int>& slots, const std::vector<int>& order, size_t offset) {
+        for (size_t i = 0; i < slots.size() && !order.empty(); i++) {
+            slots[i] = order[(offset + i) % order.size()];
+        }
+    }
+
+public:
+    ThreadPlacement(const CpuTopology& topology, int num_readers, int num_writers)
+        : policy(env_or("PLACEMENT", "none")), reader_cpus(num_readers, -1), writer_cpus(num_writers, -1) {
+        std::vector<int> order;
+        if (policy == "compact") {
+            order = topology.compact_order();
+        } else if (policy == "scatter") {
+            order = topology.scatter_order();
+        } else if (policy == "physical") {
+            order = topology.physical_core_order();
+        } else if (policy == "list") {
+            std::string both = env_or("CPUS", "");
+            assign(reader_cpus, parse_cpu_list(env_or("READER_CPUS", both)), 0);
+            assign(writer_cpus, parse_cpu_list(env_or("WRITER_CPUS", both)), 0);
+            return;
+        } else {
+            if (policy != "none") {
+                std::cerr << "Unknown PLACEMENT '" << policy << "', threads will not be pinned" << std::endl;
+            }
+            policy = "none";
+            return;
+        }
+
+        // Readers take the first slots of the order and writers continue after them
+        assign(reader_cpus, order, 0);
+        assign(writer_cpus, order, num_readers);
+    }
+
+    const std::string& name() const {
+        return policy;
+    }
+
+    // Pin the calling thread, counting and logging a failure (e.g. a CPU outside the
+    // process's affinity mask)
+    void pin(const char* role, int id, int cpu) const {
+        pin_attempts++;
+        if (!pin_current_thread(cpu)) {
+            pin_failures++;
+            std::cerr << "Could not pin " << role << " " << id << " to CPU " << cpu << "; it runs unpinned" << std::endl;
+        }
+    }
+
+    // Pin the calling reader/writer thread (1-based id); no-op when placement is "none"
+    void pin_reader(int id) const {
+        if (reader_cpus[id - 1] >= 0) pin("reader", id, reader_cpus[id - 1]);
+    }
+
+    void pin_writer(int id) const {
+        if (writer_cpus[id - 1] >= 0) pin("writer", id, writer_cpus[id - 1]);
+    }
+
+    void print_summary() const {
+        std::cout << "Placement: " << policy;
+        if (policy != "none") {
+            std::cout << " (readers -> CPUs " << format_cpu_list(reader_cpus)
+                      << "; writers -> CPUs " << format_cpu_list(writer_cpus) << ")";
+        }
+        std::cout << std::endl;
+    }
+
+    // After the run: how many of the requested pins actually took effect
+    void print_pin_report() const {
+        if (policy == "none") return;
+        std::cout << "Pin failures: " << pin_failures << " of " << pin_attempts << " threads" << std::endl;
+    }
+};
+
+#endif // READERS_WRITERS_TOPOLOGY_H
@@ -0,0 +1,132 @@
+/**
+ * readers_writers_trace.h - Low-overhead binary event recorder for the Readers-Writers demos
+ *
+ * Each worker thread appends {timestamp, thread, lock, event} records to its own buffer,
+ * so recording never takes a lock or touches a shared cache line. At the end of the run
+ * the buffers are dumped to a binary file which readers_writers_trace_convert turns into
+ * Chrome trace-event JSON for Perfetto / chrome://tracing.
+ *
+ * Tracing is enabled by setting TRACE_FILE=<path>; otherwise record calls are no-ops.
+ */
+
+#ifndef READERS_WRITERS_TRACE_H
+#define READERS_WRITERS_TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "readers_writers_bench.h"
+
+enum class TraceEvent : uint8_t {
+    READ_REQUEST,
+    READ_ACQUIRED,
+    READ_RELEASED,
+    WRITE_REQUEST,
+    WRITE_ACQUIRED,
+    WRITE_RELEASED
+};
+
+// On-disk record; fixed 16 bytes so the file can be read back with a single fread
+struct TraceRecord {
+    uint64_t timestamp_ns;  // steady_clock time since epoch
+    uint32_t thread;        // Readers are 1..num_readers, writers follow after them
+    uint16_t lock;          // Which lock the event refers to (0 for single-lock demos)
+    uint8_t event;          // TraceEvent
+    uint8_t reserved;
+};
+
+// File header written in front of the records
+struct TraceFileHeader {
+    char magic[8];          // "RWTRACE1"
+    char label[48];         // Implementation name shown as the process name
+    uint32_t num_readers;
+    uint32_t num_writers;
+    uint64_t record_count;
+};
+
+static_assert(sizeof(TraceRecord) == 16, "TraceRecord must stay 16 bytes");
+
+class TraceRecorder {
+private:
+    // Padded so that two threads never write to the same cache line
+    struct alignas(64) ThreadBuffer {
+        std::vector<TraceRecord> records;
+    };
+
+    std::string path;
+    std::string label;
+    int num_readers;
+    int num_writers;
+    std::vector<ThreadBuffer> buffers;
+
+    static uint64_t to_ns(std::chrono::steady_clock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    void append(uint32_t thread, uint16_t lock, TraceEvent event, std::chrono::steady_clock::time_point t) {
+        buffers[thread - 1].records.push_back({to_ns(t), thread, lock, static_cast<uint8_t>(event), 0});
+    }
+
+public:
+    TraceRecorder(const std::string& label, int num_readers, int num_writers, int expected_ops_per_thread = 0)
+        : path(std::getenv("TRACE_FILE") ? std::getenv("TRACE_FILE") : ""),
+          label(label), num_readers(num_readers), num_writers(num_writers) {
+        if (!enabled()) return;
+        buffers.resize(num_readers + num_writers);
+        for (auto& buffer : buffers) buffer.records.reserve(3 * expected_ops_per_thread);
+    }
+
+    bool enabled() const {
+        return !path.empty();
+    }
+
+    // Record request/acquire/release of one read by reader `id` (1-based)
+    void record_read(int id, const OpTiming& timing, uint16_t lock = 0) {
+        if (!enabled()) return;
+        uint32_t thread = id;
+        append(thread, lock, TraceEvent::READ_REQUEST, timing.requested);
+        append(thread, lock, TraceEvent::READ_ACQUIRED, timing.granted);
+        append(thread, lock, TraceEvent::READ_RELEASED, timing.released);
+    }
+
+    // Record request/acquire/release of one write by writer `id` (1-based)
+    void record_write(int id, const OpTiming& timing, uint16_t lock = 0) {
+        if (!enabled()) return;
+        uint32_t thread = num_readers + id;
+        append(thread, lock, TraceEvent::WRITE_REQUEST, timing.requested);
+        append(thread, lock, TraceEvent::WRITE_ACQUIRED, timing.granted);
+        append(thread, lock, TraceEvent::WRITE_RELEASED, timing.released);
+    }
+
+    // Dump all buffers to TRACE_FILE; must be called after the workers have been joined
+    void write() const {
+        if (!enabled()) return;
+
+        TraceFileHeader header{};
+        std::memcpy(header.magic, "RWTRACE1", sizeof(header.magic));
+        std::strncpy(header.label, label.c_str(), sizeof(header.label) - 1);
+        header.num_readers = num_readers;
+        header.num_writers = num_writers;
+        for (const auto& buffer : buffers) header.record_count += buffer.records.size();
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out) {
+            std::cerr << "Could not open trace file " << path << std::endl;
+            return;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& buffer : buffers) {
+            out.write(reinterpret_cast<const char*>(buffer.records.data()),
+                      buffer.records.size() * sizeof(TraceRecord));
+        }
+
+        std::cout << "Trace written to " << path << " (" << header.record_count << " events)" << std::endl;
+    }
+};
+
+#endif // READERS_WRITERS_TRACE_H
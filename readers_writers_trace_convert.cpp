@@ -0,0 +1,147 @@
+/**
+ * readers_writers_trace_convert.cpp - Convert a binary lock trace into Chrome trace-event JSON
+ *
+ * Usage: readers_writers_trace_convert <trace.bin> [trace.json]
+ *
+ * The input is the file written by TraceRecorder when a demo runs with TRACE_FILE set.
+ * The output opens directly in https://ui.perfetto.dev or chrome://tracing and shows:
+ * - one track per reader/writer thread with "wait" slices (request -> acquire) followed by
+ *   "read"/"write" slices (acquire -> release)
+ * - one counter track per lock with the number of active readers, active writers and
+ *   waiting threads, which makes reader groups, writer phases and handoff gaps visible
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "readers_writers_trace.h"
+
+// Escape a string for inclusion in a JSON string literal
+static std::string json_escape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+// Chrome trace timestamps are microseconds; keep sub-microsecond precision
+static std::string to_us(uint64_t ns, uint64_t origin_ns) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", (ns - origin_ns) / 1000.0);
+    return buffer;
+}
+
+static bool is_read(uint8_t event) {
+    return event <= static_cast<uint8_t>(TraceEvent::READ_RELEASED);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <trace.bin> [trace.json]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        std::cerr << "Could not open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    TraceFileHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, "RWTRACE1", sizeof(header.magic)) != 0) {
+        std::cerr << argv[1] << " is not a readers-writers trace file" << std::endl;
+        return 1;
+    }
+
+    std::vector<TraceRecord> records(header.record_count);
+    in.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(TraceRecord));
+    if (!in) {
+        std::cerr << "Trace file is truncated" << std::endl;
+        return 1;
+    }
+
+    std::ofstream file_out;
+    if (argc > 2) {
+        file_out.open(argv[2]);
+        if (!file_out) {
+            std::cerr << "Could not open " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = argc > 2 ? file_out : std::cout;
+
+    // Events are stored per thread; order them globally for the counter tracks
+    std::stable_sort(records.begin(), records.end(), [](const TraceRecord& a, const TraceRecord& b) {
+        return a.timestamp_ns < b.timestamp_ns;
+    });
+    uint64_t origin_ns = records.empty() ? 0 : records.front().timestamp_ns;
+    std::string label(header.label, strnlen(header.label, sizeof(header.label)));
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\""
+        << json_escape(label) << "\"}}";
+    for (uint32_t t = 1; t <= header.num_readers + header.num_writers; t++) {
+        bool reader = t <= header.num_readers;
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t
+            << ",\"args\":{\"name\":\"" << (reader ? "Reader " : "Writer ")
+            << (reader ? t : t - header.num_readers) << "\"}}";
+    }
+
+    struct LockState {
+        int readers = 0;
+        int writers = 0;
+        int waiting = 0;
+    };
+    std::map<uint16_t, LockState> locks;
+    std::map<uint32_t, uint64_t> requested_at;
+    std::map<uint32_t, uint64_t> acquired_at;
+
+    for (const TraceRecord& r : records) {
+        LockState& lock = locks[r.lock];
+        TraceEvent event = static_cast<TraceEvent>(r.event);
+        const char* op = is_read(r.event) ? "read" : "write";
+
+        switch (event) {
+        case TraceEvent::READ_REQUEST:
+        case TraceEvent::WRITE_REQUEST:
+            requested_at[r.thread] = r.timestamp_ns;
+            lock.waiting++;
+            break;
+        case TraceEvent::READ_ACQUIRED:
+        case TraceEvent::WRITE_ACQUIRED:
+            acquired_at[r.thread] = r.timestamp_ns;
+            lock.waiting--;
+            (event == TraceEvent::READ_ACQUIRED ? lock.readers : lock.writers)++;
+            out << ",\n{\"name\":\"wait " << op << "\",\"cat\":\"wait\",\"ph\":\"X\",\"pid\":1,\"tid\":" << r.thread
+                << ",\"ts\":" << to_us(requested_at[r.thread], origin_ns)
+                << ",\"dur\":" << to_us(r.timestamp_ns, requested_at[r.thread])
+                << ",\"args\":{\"lock\":" << r.lock << "}}";
+            break;
+        case TraceEvent::READ_RELEASED:
+        case TraceEvent::WRITE_RELEASED:
+            (event == TraceEvent::READ_RELEASED ? lock.readers : lock.writers)--;
+            out << ",\n{\"name\":\"" << op << "\",\"cat\":\"hold\",\"ph\":\"X\",\"pid\":1,\"tid\":" << r.thread
+                << ",\"ts\":" << to_us(acquired_at[r.thread], origin_ns)
+                << ",\"dur\":" << to_us(r.timestamp_ns, acquired_at[r.thread])
+                << ",\"args\":{\"lock\":" << r.lock << "}}";
+            break;
+        }
+
+        out << ",\n{\"name\":\"lock " << r.lock << "\",\"ph\":\"C\",\"pid\":1,\"ts\":"
+            << to_us(r.timestamp_ns, origin_ns) << ",\"args\":{\"readers\":" << lock.readers
+            << ",\"writers\":" << lock.writers << ",\"waiting\":" << lock.waiting << "}}";
+    }
+
+    out << "\n]}\n";
+
+    std::cerr << "Converted " << records.size() << " events from " << argv[1] << std::endl;
+    return 0;
+}
@@ -0,0 +1,196 @@
+/**
+ * readers_writers_wait.h - Spin-then-park wait strategy shared by the blocking locks
+ *
+ * Going straight to condition_variable::wait or sem_wait costs two context switches per
+ * handoff, even when the holder releases a few hundred nanoseconds later. WaitStrategy
+ * resolves a wait in up to three stages:
+ *
+ *   1. spin   - re-check with a CPU pause instruction and exponential backoff
+ *   2. yield  - re-check a few times after std::this_thread::yield()
+ *   3. park   - block in the kernel (condition variable, semaphore, shared_mutex)
+ *
+ * The strategy is chosen with WAIT_STRATEGY:
+ *
+ *   WAIT_STRATEGY=adaptive  Spin budget follows the observed wait times (default)
+ *   WAIT_STRATEGY=spin      Always spin for the full WAIT_SPIN_US budget
+ *   WAIT_STRATEGY=park      Block immediately, as the locks originally did
+ *
+ * WAIT_SPIN_US caps the spin stage (default 50 us) and WAIT_YIELDS sets the number of
+ * yield rounds (default 4). In adaptive mode every wait feeds its duration - the remaining
+ * hold time of whoever owned the lock - into a moving average; the spin budget is twice
+ * that average while it stays below the cap and drops to zero (park at once) when the
+ * critical sections are long. Parked waits are still measured, so spinning comes back as
+ * soon as hold times shrink again.
+ *
+ * wait() re-checks its predicate under the lock's mutex, which it only takes with
+ * try_lock while spinning or yielding, so waiters never block on the mutex before parking.
+ */
+
+#ifndef READERS_WRITERS_WAIT_H
+#define READERS_WRITERS_WAIT_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Tell the CPU we are busy-waiting (saves power and frees the SMT sibling)
+inline void cpu_pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+class WaitStrategy {
+public:
+    enum class Mode { ADAPTIVE, SPIN, PARK };
+
+private:
+    enum class Stage { SPIN, YIELD, NONE };
+
+    Mode mode;
+    long long max_spin_ns;
+    int yield_rounds;
+
+    std::atomic<long long> avg_wait_ns;    // Moving average of wait durations (adaptive mode)
+    std::atomic<long long> uncontended{0}; // Acquired without waiting at all
+    std::atomic<long long> spun{0};
+    std::atomic<long long> yielded{0};
+    std::atomic<long long> parked{0};
+
+    using Clock = std::chrono::steady_clock;
+
+    static long long env_or(const char* name, long long fallback) {
+        return std::getenv(name) ? std::stoll(std::getenv(name)) : fallback;
+    }
+
+    long long spin_budget_ns() const {
+        if (mode == Mode::PARK) return 0;
+        if (mode == Mode::SPIN) return max_spin_ns;
+        long long avg = avg_wait_ns.load(std::memory_order_relaxed);
+        return avg <= max_spin_ns ? std::min(max_spin_ns, 2 * avg) : 0;
+    }
+
+    // Fold one wait into the moving average (weight 1/8, like glibc's adaptive mutex)
+    void observe(Clock::time_point start) {
+        if (mode != Mode::ADAPTIVE) return;
+        long long waited = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        long long avg = avg_wait_ns.load(std::memory_order_relaxed);
+        avg_wait_ns.store(avg + (waited - avg) / 8, std::memory_order_relaxed);
+    }
+
+    // Run the spin and yield stages; `check` re-tests the wait condition and returns true
+    // once it holds. Returns the stage that succeeded, or NONE if the caller must park.
+    template <typename Check>
+    Stage spin_then_yield(Check check) {
+        long long budget = spin_budget_ns();
+        if (budget == 0) return Stage::NONE;
+
+        Clock::time_point deadline = Clock::now() + std::chrono::nanoseconds(budget);
+        for (int pauses = 1; Clock::now() < deadline; pauses = std::min(pauses * 2, 64)) {
+            for (int i = 0; i < pauses; i++) cpu_pause();
+            if (check()) return Stage::SPIN;
+        }
+
+        for (int i = 0; i < yield_rounds; i++) {
+            std::this_thread::yield();
+            if (check()) return Stage::YIELD;
+        }
+        return Stage::NONE;
+    }
+
+    void count(Stage stage) {
+        (stage == Stage::SPIN ? spun : stage == Stage::YIELD ? yielded : parked).fetch_add(1, std::memory_order_relaxed);
+    }
+
+public:
+    WaitStrategy()
+        : mode(Mode::ADAPTIVE),
+          max_spin_ns(env_or("WAIT_SPIN_US", 50) * 1000),
+          yield_rounds(static_cast<int>(env_or("WAIT_YIELDS", 4))),
+          avg_wait_ns(max_spin_ns / 2) {
+        std::string name = std::getenv("WAIT_STRATEGY") ? std::getenv("WAIT_STRATEGY") : "adaptive";
+        if (name == "spin") {
+            mode = Mode::SPIN;
+        } else if (name == "park") {
+            mode = Mode::PARK;
+        } else if (name != "adaptive") {
+            std::cerr << "Unknown WAIT_STRATEGY '" << name << "', using adaptive" << std::endl;
+        }
+    }
+
+    // Replacement for cv.wait(lock, ready): `lock` must be held on entry and is held on return
+    template <typename Predicate>
+    void wait(std::unique_lock<std::mutex>& lock, std::condition_variable& cv, Predicate ready) {
+        if (ready()) {
+            uncontended.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        Clock::time_point start = Clock::now();
+        lock.unlock();
+        // Poll with try_lock: it never sleeps in the kernel, and a spinner that finds the
+        // mutex taken backs off instead of queueing against the thread that is releasing
+        Stage stage = spin_then_yield([&] {
+            if (!lock.try_lock()) return false;
+            if (ready()) return true;
+            lock.unlock();
+            return false;
+        });
+        if (stage == Stage::NONE) {
+            lock.lock();
+            cv.wait(lock, ready);
+        }
+        count(stage);
+        observe(start);
+    }
+
+    // Acquire a primitive that has a non-blocking variant, e.g. sem_trywait / sem_wait
+    // or try_lock_shared / lock_shared
+    template <typename TryAcquire, typename Acquire>
+    void acquire(TryAcquire try_acquire, Acquire block) {
+        if (try_acquire()) {
+            uncontended.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        Clock::time_point start = Clock::now();
+        Stage stage = spin_then_yield(try_acquire);
+        if (stage == Stage::NONE) block();
+        count(stage);
+        observe(start);
+    }
+
+    // Count an acquisition that bypassed wait()/acquire() because the caller saw it was free
+    void record_uncontended() {
+        uncontended.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const char* name() const {
+        return mode == Mode::ADAPTIVE ? "adaptive" : mode == Mode::SPIN ? "spin" : "park";
+    }
+
+    void print_report() const {
+        long long waits = spun + yielded + parked;
+        auto percent = [waits](long long n) { return waits > 0 ? 100.0 * n / waits : 0.0; };
+
+        std::cout << "\n----- WAIT STRATEGY -----" << std::endl;
+        std::cout << "Wait strategy: " << name() << " (spin limit " << max_spin_ns / 1000.0
+                  << " us, current budget " << spin_budget_ns() / 1000.0 << " us)" << std::endl;
+        std::cout << "Acquired without waiting: " << uncontended << std::endl;
+        std::cout << "Waits resolved by spinning: " << spun << " (" << percent(spun) << "%)" << std::endl;
+        std::cout << "Waits resolved by yielding: " << yielded << " (" << percent(yielded) << "%)" << std::endl;
+        std::cout << "Waits resolved by parking: " << parked << " (" << percent(parked) << "%)" << std::endl;
+    }
+};
+
+#endif // READERS_WRITERS_WAIT_H